@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class RarcFile;
+class BmdFile;
+
+// Shares archives, and the models in them, between everything that uses them, so a galaxy with
+// 300 coins opens Coin.arc once. Asking for something that's still loading waits for that load.
+// Entries nobody holds any more stay around while they fit in the memory budget, least recently used going first
+class ArchiveCache
+{
+    struct Entry
+    {
+        std::shared_future<std::shared_ptr<void>> value;
+        bool loaded = false;
+        uint64_t size = 0;
+        uint64_t lastUse = 0;
+    };
+
+    static std::unordered_map<std::string, Entry> m_entries;
+    static uint64_t m_memoryBudget;
+    static uint64_t m_memoryUsed;
+    static uint64_t m_clock;
+    static std::mutex m_lock;
+    static std::mutex m_openLock;
+
+    template<typename T, typename Load>
+    static std::shared_ptr<T> get(const std::string& key, Load load);
+    static void evict(uint64_t budget);
+
+public:
+    static std::shared_ptr<RarcFile> archive(const QString& path);
+    // modelPath is the BMD/BDL's path inside the archive. the model keeps its archive loaded
+    static std::shared_ptr<BmdFile> model(const QString& archivePath, const QString& modelPath);
+
+    // how much the cache may hold, in decompressed bytes. what's in use can't be dropped, so that can go over
+    static void setMemoryBudget(uint64_t bytes);
+    // drops every entry that isn't in use
+    static void clear();
+};
@@ -2,7 +2,14 @@
 
 #include "Constants.h"
 #include "Util.h"
+#include "io/ByteReader.h"
+#include "io/ByteWriter.h"
 
+#include <array>
+#include <bit>
+#include <memory>
+#include <span>
+#include <type_traits>
 #include <vector>
 #include <QString>
 
@@ -13,9 +20,29 @@ protected:
 
     mutable uint32_t m_curPos = 0;
 
+    // all reads go through m_view. it normally points at m_contents, but read-only
+    // backends can point it at memory they don't own (e.g. a mapped file), kept alive by m_viewOwner
+    std::span<const uint8_t> m_view;
+    std::shared_ptr<const void> m_viewOwner;
+
     std::vector<uint8_t> m_contents;
-    bool m_modifiedFlag = false;
+    DirtyRanges m_dirty; // what the write functions touched
+    bool m_unsaved = false; // contents that aren't on disk yet, set by setContents() and makeWritable()
+
+    struct ReadCursor;
+    struct WriteCursor;
+
+    void borrow(std::span<const uint8_t> bytes, std::shared_ptr<const void> owner);
+    bool isBorrowed() const;
+    void makeWritable(); // copies a borrowed view into m_contents, call before writing
+    void markSaved(); // for backends, once the contents are on disk
 public:
+    BaseFile() = default;
+    virtual ~BaseFile() = default;
+
+    // m_view may point into m_contents, so copies would alias the original
+    BaseFile(const BaseFile&) = delete;
+    BaseFile& operator=(const BaseFile&) = delete;
 
     virtual void save() = 0;
     virtual void close() = 0; // without saving!
@@ -31,6 +58,10 @@ public:
     virtual void position(uint32_t newPos);
     virtual void skip(uint32_t count);
 
+    // an independent cursor over the contents, for parsing without touching position().
+    // it covers all of them, so a lazily loaded file loads everything first
+    ByteReader reader(uint32_t offset = 0) const;
+
     uint8_t readByte() const;
     uint16_t readShort() const;
     int16_t readShortS() const;
@@ -39,14 +70,52 @@ public:
     QString readString(uint32_t length, const char* enc = "ASCII") const;
     std::vector<uint8_t> readBytes(uint32_t count) const;
 
+    // bulk reads straight into the caller's buffer, swapping whole arrays at once
+    void readBytes(std::span<uint8_t> out) const;
+    void readShorts(std::span<uint16_t> out) const;
+    void readInts(std::span<uint32_t> out) const;
+    void readFloats(std::span<float> out) const;
+
+    // reads a record made only of 32-bit fields (vectors, matrices...), each one swapped to host order
+    template<typename T>
+    T readStruct() const
+    {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(uint32_t) == 0);
+
+        std::array<uint32_t, sizeof(T) / sizeof(uint32_t)> words;
+        readInts(words);
+
+        return std::bit_cast<T>(words);
+    }
+
     void writeByte(uint8_t val);
     void writeShort(uint16_t val);
     void writeInt(uint32_t val);
     void writeFloat(float val);
     int writeString(const QString& str, const char* enc = "ASCII");
-    void writeBytes(const std::vector<uint8_t>& bytes);
+    void writeBytes(std::span<const uint8_t> bytes);
+
+    // bulk writes, growing the file as needed
+    void writeShorts(std::span<const uint16_t> vals);
+    void writeInts(std::span<const uint32_t> vals);
+    void writeFloats(std::span<const float> vals);
+
+    // whether anything changed since the file was loaded or last saved. the ranges only cover
+    // the write functions, setContents() replaces everything and starts them over
+    bool isModified() const;
+    const DirtyRanges& dirtyRanges() const;
+
+    // makes sure the first end bytes of the contents are there. files that fill in their contents
+    // as they're read (Yaz0File) override this, and throw if they can't. getContents(), slice() and the reads call it for you
+    virtual void ensureLoaded(uint32_t end) const;
+
+    virtual std::span<const uint8_t> getContents() const;
+
+    // shared ownership of the memory behind getContents(), so spans into it can outlive this file.
+    // a later write here copies the contents first, so those spans never see it change
+    std::shared_ptr<const void> shareContents();
 
-    virtual const std::vector<uint8_t>& getContents() const;
     virtual void setContents(const std::vector<uint8_t>& bytes);
-    virtual std::span<uint8_t> slice(uint32_t start, uint32_t end);
+    virtual void setContents(std::vector<uint8_t>&& bytes);
+    virtual std::span<const uint8_t> slice(uint32_t start, uint32_t end) const;
 };
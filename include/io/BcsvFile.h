@@ -2,6 +2,13 @@
 
 #include "io/BaseFile.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <variant>
@@ -16,6 +23,20 @@ public:
     // ----------------------------
 
     static uint32_t fieldNameToHash(const QString& fieldName);
+
+    // the same hash, for names known at compile time (see operator""_bcsv). the game hashes signed chars
+    static constexpr uint32_t fieldHash(std::string_view fieldName)
+    {
+        uint32_t ret = 0;
+        for(char c : fieldName)
+        {
+            ret *= 0x1F;
+            ret += (signed char) c;
+        }
+
+        return ret;
+    }
+
     static QString hashToFieldName(uint32_t hash);
     static void addHash(QString field);
 
@@ -33,11 +54,82 @@ public:
 
     typedef std::variant<uint32_t, uint16_t, uint8_t, float, QString> Value;
 
+    // one member of a typed record (see Entry::read), by its offset in the record
+    struct RecordField {
+        uint32_t nameHash;
+        uint32_t offset;
+        uint8_t type;
+    };
+
+private:
+    friend struct BcsvSchema;
+
+    static uint32_t valueIndex(uint8_t type); // the Value alternative a field type is stored as
+
+    enum class StringId : uint32_t {};
+
+    // one field's values for every row, in the Value alternative matching its type.
+    // strings are ids into the table's string column
+    struct Column {
+        uint32_t nameHash;
+        std::variant<std::vector<uint32_t>, std::vector<uint16_t>, std::vector<uint8_t>, std::vector<float>, std::vector<StringId>> values;
+
+        std::optional<Field> pending; // where it is in the file while it's still undecoded
+    };
+
+    // the file's bytes, for a table whose columns get decoded as they're asked for
+    struct Source {
+        std::span<const uint8_t> bytes;
+        std::shared_ptr<const void> owner;
+
+        uint32_t dataOffset;
+        uint32_t entrySize;
+        uint32_t stringTableOffset;
+
+        std::unordered_map<uint32_t, StringId> stringsAt; // the strings decoded so far, by offset
+    };
+
+    struct Table {
+        std::vector<Column> columns;
+        uint32_t numRows = 0;
+
+        // every distinct string once, shared by all the string columns
+        std::vector<QString> strings;
+        std::unordered_map<QString, uint32_t> stringIds;
+
+        std::optional<Source> source;
+
+        // decoding a column changes the table, and copies of a row can be read from any thread.
+        // so until every column is decoded, anything that looks at the table holds the lock
+        std::atomic<uint32_t> numPending = 0;
+        std::mutex decodeLock;
+
+        // an empty lock once nothing is pending, or for tables that were never lazy
+        std::unique_lock<std::mutex> lockIfPending();
+
+        // decodes the column first if it's still pending. call it with lockIfPending() held
+        Column* find(uint32_t nameHash);
+        void decode(Column& column);
+        Column& addColumn(uint32_t nameHash, const Value& fill);
+
+        StringId intern(const QString& str);
+        Value get(const Column& column, uint32_t row) const;
+        void set(Column& column, uint32_t row, const Value& val);
+    };
+
+public:
+    // A view of one row. It shares ownership of its table, so it stays valid when the BcsvFile is gone,
+    // and copies look at the same row. A default constructed entry gets a one-row table of its own on first insert
     class Entry
     {
-        mutable std::unordered_map<uint32_t, Value> m_entry;
+        friend class BcsvFile;
+
+        std::shared_ptr<Table> m_table;
+        uint32_t m_row = 0;
 
     public:
+        Entry() = default;
+        Entry(std::shared_ptr<Table> table, uint32_t row) : m_table(std::move(table)), m_row(row) {}
 
         Value operator[](const QString& key) const;
         Value operator[](uint32_t key) const;
@@ -55,13 +147,37 @@ public:
         QString getstr(const QString& key, const QString& defaultValue = "") const;
         QString getstr(uint32_t key, const QString& defaultValue = "") const;
 
+        // sets the field, adding it if it's new. a field added to a loaded row goes in its whole table,
+        // defaulting to zero in the other rows (the file's own fields are only changed by addField/removeField)
         void insert(const QString& key, const Value& val);
         void insert(uint32_t key, const Value& val);
 
-        void erase(const QString& key);
-        void erase(uint32_t key);
-
         bool contains(const QString& key) const;
+        bool contains(uint32_t key) const;
+
+        // copies every field Record lists in Record::FIELDS into a record in one go.
+        // the ones the row doesn't have keep the value they have in record
+        template<typename Record>
+        Record read(Record record = Record()) const
+        {
+            static_assert(std::is_trivially_copyable_v<Record>);
+
+            readFields(Record::FIELDS, &record);
+            return record;
+        }
+
+        // and back, leaving out the ones the row doesn't have
+        template<typename Record>
+        void write(const Record& record)
+        {
+            static_assert(std::is_trivially_copyable_v<Record>);
+
+            writeFields(Record::FIELDS, &record);
+        }
+
+    private:
+        void readFields(std::span<const RecordField> fields, void* record) const;
+        void writeFields(std::span<const RecordField> fields, const void* record);
     };
 
 private:
@@ -73,9 +189,12 @@ private:
     // ------------------------
 
     BaseFile* file;
+    std::shared_ptr<Table> m_table;
 
 public:
-    BcsvFile(BaseFile* inRarcFile);
+    // a lazy file keeps the file's bytes and only decodes a field, for every row, the first time one of them
+    // looks it up. good for reading a few fields of a table
+    BcsvFile(BaseFile* inRarcFile, bool lazy = false);
 
     void save();
     void close();
@@ -87,3 +206,9 @@ public:
     std::vector<Field> m_fields;
     std::vector<Entry> m_entries;
 };
+
+// "pos_x"_bcsv is that field's hash, worked out by the compiler
+consteval uint32_t operator""_bcsv(const char* fieldName, size_t length)
+{
+    return BcsvFile::fieldHash(std::string_view(fieldName, length));
+}
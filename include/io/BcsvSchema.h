@@ -0,0 +1,41 @@
+#pragma once
+
+#include "io/BcsvFile.h"
+
+#include <array>
+#include <span>
+#include <QString>
+
+// What we know about a BCSV table ahead of time: the fields a new row of it gets, with their types and defaults.
+// Anything else a file has stays a dynamic field of its rows
+struct BcsvSchema
+{
+    enum Game : uint8_t { BOTH = 0, SMG1 = 1, SMG2 = 2 };
+
+    struct Field {
+        uint32_t nameHash;
+        uint8_t type;
+        uint8_t game;
+
+        uint32_t defaultBits; // the default as the field stores it, float ones included
+        const char* defaultString;
+    };
+
+    const char* tableName;
+    std::span<const Field> fields;
+
+    // nullptr for tables we don't know
+    static const BcsvSchema* find(const QString& tableName);
+
+    // a one-row table with every field of the game (1 or 2) at its default, built in one go
+    BcsvFile::Entry newRow(int game) const;
+
+    // where every placed object is, as a typed record for Entry::read/write
+    struct Placement {
+        float pos_x = 0, pos_y = 0, pos_z = 0;
+        float dir_x = 0, dir_y = 0, dir_z = 0;
+        float scale_x = 1, scale_y = 1, scale_z = 1;
+
+        static const std::array<BcsvFile::RecordField, 9> FIELDS;
+    };
+};
@@ -29,7 +29,7 @@ class BmdFile
 
     struct INF1
     {
-        std::span<uint8_t> hierarchyData;
+        std::span<const uint8_t> hierarchyData;
         J3DLoadFlags loadFlags;
     };
 
@@ -258,6 +258,8 @@ class BmdFile
 
     // actual class starts here
     BaseFile* file;
+    std::shared_ptr<const void> m_contentsOwner; // keeps the spans below valid
+    BigEndianReader m_reader;
 
     void readINF1();
     void readVTX1();
@@ -294,6 +296,9 @@ public:
     void save();
     void close();
 
+    // roughly what parsing allocated. the file's bytes aren't counted, the textures and vertex arrays point into them
+    uint64_t memorySize() const;
+
     // TODO break these out maybe
 
     // INF1
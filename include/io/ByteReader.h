@@ -0,0 +1,197 @@
+#pragma once
+
+#include "io/ByteStrings.h"
+#include "io/ByteSwap.h"
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <QString>
+
+// A read cursor over bytes it doesn't own, with its own position.
+// Copies are cheap and independent, so any number of parsers (on any number of threads)
+// can walk the same buffer at once, as long as the buffer outlives them.
+//
+// Derived decides whether values need swapping through needsSwap(). When that's a
+// constant (EndianReader) every read compiles down to a load + bswap.
+template<typename Derived>
+class BasicReader
+{
+protected:
+    std::span<const uint8_t> m_data;
+    uint32_t m_curPos = 0;
+
+    // returns a pointer to the next count bytes and moves past them
+    const uint8_t* take(uint32_t count)
+    {
+        assert(m_curPos + count <= m_data.size()); // read out of bounds
+
+        const uint8_t* ret = m_data.data() + m_curPos;
+        m_curPos += count;
+        return ret;
+    }
+
+    bool swapping() const
+    {
+        return static_cast<const Derived*>(this)->needsSwap();
+    }
+
+public:
+    BasicReader() = default;
+
+    BasicReader(std::span<const uint8_t> data, uint32_t pos)
+            : m_data(data), m_curPos(pos) {}
+
+    uint32_t getLength() const { return m_data.size(); }
+
+    uint32_t position() const { return m_curPos; }
+    void position(uint32_t newPos) { m_curPos = newPos; }
+    void skip(uint32_t count) { m_curPos += count; }
+
+    uint8_t readByte()
+    {
+        return *take(1);
+    }
+
+    uint16_t readShort()
+    {
+        uint16_t ret;
+        memcpy(&ret, take(sizeof(ret)), sizeof(ret));
+
+        return swapping() ? ByteSwap::swap16(ret) : ret;
+    }
+
+    int16_t readShortS()
+    {
+        return int16_t(readShort());
+    }
+
+    uint32_t readInt()
+    {
+        uint32_t ret;
+        memcpy(&ret, take(sizeof(ret)), sizeof(ret));
+
+        return swapping() ? ByteSwap::swap32(ret) : ret;
+    }
+
+    float readFloat()
+    {
+        return std::bit_cast<float>(readInt());
+    }
+
+    // length == 0 reads up to the NUL terminator
+    QString readString(uint32_t length, const char* enc = "ASCII")
+    {
+        if(length != 0)
+            return ByteStrings::decode(std::span(take(length), length), enc);
+
+        // NUL can't be the second byte of a Shift-JIS char, so this is safe for it too
+        const uint8_t* start = m_data.data() + m_curPos;
+        const uint8_t* end = (const uint8_t*) memchr(start, 0, m_data.size() - m_curPos);
+        assert(end != nullptr); // unterminated string
+
+        uint32_t strLength = end - start;
+        m_curPos += strLength + 1;
+
+        return ByteStrings::decode(std::span(start, strLength), enc);
+    }
+
+    std::vector<uint8_t> readBytes(uint32_t count)
+    {
+        const uint8_t* src = take(count);
+        return std::vector<uint8_t>(src, src + count);
+    }
+
+    // bulk reads straight into the caller's buffer, swapping whole arrays at once
+    void readBytes(std::span<uint8_t> out)
+    {
+        memcpy(out.data(), take(out.size()), out.size());
+    }
+
+    void readShorts(std::span<uint16_t> out)
+    {
+        const uint8_t* src = take(out.size_bytes());
+
+        if(swapping())
+            ByteSwap::copySwap16(src, out.data(), out.size());
+        else
+            memcpy(out.data(), src, out.size_bytes());
+    }
+
+    void readInts(std::span<uint32_t> out)
+    {
+        const uint8_t* src = take(out.size_bytes());
+
+        if(swapping())
+            ByteSwap::copySwap32(src, out.data(), out.size());
+        else
+            memcpy(out.data(), src, out.size_bytes());
+    }
+
+    void readFloats(std::span<float> out)
+    {
+        // floats swap exactly like ints
+        const uint8_t* src = take(out.size_bytes());
+
+        if(swapping())
+            ByteSwap::copySwap32(src, out.data(), out.size());
+        else
+            memcpy(out.data(), src, out.size_bytes());
+    }
+
+    // reads a record made only of 32-bit fields (vectors, matrices...), each one swapped to host order
+    template<typename T>
+    T readStruct()
+    {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(uint32_t) == 0);
+
+        std::array<uint32_t, sizeof(T) / sizeof(uint32_t)> words;
+        readInts(words);
+
+        return std::bit_cast<T>(words);
+    }
+
+    std::span<const uint8_t> slice(uint32_t start, uint32_t end) const
+    {
+        return m_data.subspan(start, end - start);
+    }
+
+    std::span<const uint8_t> data() const { return m_data; }
+};
+
+// endianness picked at compile time. every GameCube/Wii format is big-endian, so parsers use these
+template<std::endian Order>
+class EndianReader : public BasicReader<EndianReader<Order>>
+{
+public:
+    EndianReader() = default;
+
+    EndianReader(std::span<const uint8_t> data, uint32_t pos = 0)
+            : BasicReader<EndianReader<Order>>(data, pos) {}
+
+    static constexpr bool needsSwap() { return Order != std::endian::native; }
+};
+
+typedef EndianReader<std::endian::big> BigEndianReader;
+typedef EndianReader<std::endian::little> LittleEndianReader;
+
+// endianness picked at runtime, for BaseFile and the odd little-endian file
+class ByteReader : public BasicReader<ByteReader>
+{
+    bool m_bigEndian = true;
+
+public:
+    ByteReader() = default;
+
+    ByteReader(std::span<const uint8_t> data, bool bigEndian = true, uint32_t pos = 0)
+            : BasicReader<ByteReader>(data, pos), m_bigEndian(bigEndian) {}
+
+    void setBigEndian(bool big) { m_bigEndian = big; }
+    bool isBigEndian() const { return m_bigEndian; }
+
+    bool needsSwap() const { return m_bigEndian != ByteSwap::NATIVE_BIG; }
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <QByteArray>
+#include <QString>
+
+// text encoding for the strings inside game files.
+// "ASCII"/"UTF-8" and "Shift-JIS" are handled natively, anything else goes through a cached QTextCodec
+namespace ByteStrings
+{
+    QString decode(std::span<const uint8_t> bytes, const char* enc);
+    QByteArray encode(const QString& str, const char* enc);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace ByteSwap
+{
+    // the formats we read are big-endian, so most hosts have to swap
+    constexpr bool NATIVE_BIG = std::endian::native == std::endian::big;
+
+    // compilers turn these into a single bswap/rev instruction
+    constexpr uint16_t swap16(uint16_t val)
+    {
+        return uint16_t((val >> 8) | (val << 8));
+    }
+
+    constexpr uint32_t swap32(uint32_t val)
+    {
+        return ((val >> 24) & 0x000000FF) |
+               ((val >>  8) & 0x0000FF00) |
+               ((val <<  8) & 0x00FF0000) |
+               ((val << 24) & 0xFF000000);
+    }
+
+    // copy count values from src to dst, reversing the bytes of every value.
+    // neither pointer needs to be aligned, and src == dst swaps in place.
+    // these use SSE2/SSSE3/NEON when available, falling back to a scalar loop
+    void copySwap16(const void* src, void* dst, size_t count);
+    void copySwap32(const void* src, void* dst, size_t count);
+}
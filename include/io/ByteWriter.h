@@ -0,0 +1,208 @@
+#pragma once
+
+#include "io/ByteStrings.h"
+#include "io/ByteSwap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+#include <QString>
+
+// Which byte ranges of a buffer were written, kept sorted and merged.
+// Sequential writes just extend the last range, so this stays tiny in practice.
+class DirtyRanges
+{
+    std::vector<std::pair<uint32_t, uint32_t>> m_ranges; // [begin, end)
+
+public:
+    void add(uint32_t begin, uint32_t end)
+    {
+        if(begin >= end)
+            return;
+
+        // fast path: touching or extending the last range
+        if(!m_ranges.empty() && begin >= m_ranges.back().first && begin <= m_ranges.back().second)
+        {
+            m_ranges.back().second = std::max(m_ranges.back().second, end);
+            return;
+        }
+
+        auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), std::make_pair(begin, end));
+        it = m_ranges.insert(it, {begin, end});
+
+        // merge with the previous range, then swallow the following ones
+        if(it != m_ranges.begin() && std::prev(it)->second >= it->first)
+        {
+            std::prev(it)->second = std::max(std::prev(it)->second, it->second);
+            it = std::prev(m_ranges.erase(it));
+        }
+
+        auto next = std::next(it);
+        while(next != m_ranges.end() && next->first <= it->second)
+        {
+            it->second = std::max(it->second, next->second);
+            next = m_ranges.erase(next);
+        }
+    }
+
+    void clear() { m_ranges.clear(); }
+    bool empty() const { return m_ranges.empty(); }
+
+    const std::vector<std::pair<uint32_t, uint32_t>>& ranges() const { return m_ranges; }
+};
+
+// An append/seek cursor that writes into a byte vector, growing it geometrically as needed.
+// Spans go in with one memcpy (or one vectorized swap), and every write is recorded in an optional DirtyRanges.
+//
+// Like BasicReader, Derived decides whether values need swapping through needsSwap().
+template<typename Derived>
+class BasicWriter
+{
+protected:
+    std::vector<uint8_t>* m_data;
+    DirtyRanges* m_dirty;
+    uint32_t m_curPos = 0;
+
+    // makes room for count bytes at the cursor, and returns where they go
+    uint8_t* reserve(uint32_t count)
+    {
+        uint32_t end = m_curPos + count;
+        if(end > m_data->size())
+        {
+            if(end > m_data->capacity())
+                m_data->reserve(std::max<size_t>(end, m_data->capacity() * 2));
+
+            m_data->resize(end);
+        }
+
+        if(m_dirty != nullptr)
+            m_dirty->add(m_curPos, end);
+
+        uint8_t* ret = m_data->data() + m_curPos;
+        m_curPos = end;
+        return ret;
+    }
+
+    bool swapping() const
+    {
+        return static_cast<const Derived*>(this)->needsSwap();
+    }
+
+public:
+    BasicWriter(std::vector<uint8_t>& data, uint32_t pos, DirtyRanges* dirty)
+            : m_data(&data), m_dirty(dirty), m_curPos(pos) {}
+
+    uint32_t getLength() const { return m_data->size(); }
+
+    uint32_t position() const { return m_curPos; }
+    void position(uint32_t newPos) { m_curPos = newPos; }
+    void skip(uint32_t count) { m_curPos += count; }
+
+    void writeByte(uint8_t val)
+    {
+        *reserve(1) = val;
+    }
+
+    void writeShort(uint16_t val)
+    {
+        if(swapping())
+            val = ByteSwap::swap16(val);
+
+        memcpy(reserve(sizeof(val)), &val, sizeof(val));
+    }
+
+    void writeInt(uint32_t val)
+    {
+        if(swapping())
+            val = ByteSwap::swap32(val);
+
+        memcpy(reserve(sizeof(val)), &val, sizeof(val));
+    }
+
+    void writeFloat(float val)
+    {
+        writeInt(std::bit_cast<uint32_t>(val));
+    }
+
+    // returns the number of bytes written
+    int writeString(const QString& str, const char* enc = "ASCII")
+    {
+        QByteArray strBytes = ByteStrings::encode(str, enc);
+        memcpy(reserve(strBytes.length()), strBytes.constData(), strBytes.length());
+
+        return strBytes.length();
+    }
+
+    void writeBytes(std::span<const uint8_t> bytes)
+    {
+        memcpy(reserve(bytes.size()), bytes.data(), bytes.size());
+    }
+
+    void writeShorts(std::span<const uint16_t> vals)
+    {
+        uint8_t* dst = reserve(vals.size_bytes());
+
+        if(swapping())
+            ByteSwap::copySwap16(vals.data(), dst, vals.size());
+        else
+            memcpy(dst, vals.data(), vals.size_bytes());
+    }
+
+    void writeInts(std::span<const uint32_t> vals)
+    {
+        uint8_t* dst = reserve(vals.size_bytes());
+
+        if(swapping())
+            ByteSwap::copySwap32(vals.data(), dst, vals.size());
+        else
+            memcpy(dst, vals.data(), vals.size_bytes());
+    }
+
+    void writeFloats(std::span<const float> vals)
+    {
+        uint8_t* dst = reserve(vals.size_bytes());
+
+        if(swapping())
+            ByteSwap::copySwap32(vals.data(), dst, vals.size());
+        else
+            memcpy(dst, vals.data(), vals.size_bytes());
+    }
+
+    void fill(uint8_t val, uint32_t count)
+    {
+        memset(reserve(count), val, count);
+    }
+
+    // pads with val until the position is a multiple of alignment (a power of two)
+    void align(uint32_t alignment, uint8_t val = 0)
+    {
+        uint32_t aligned = (m_curPos + alignment - 1) & ~(alignment - 1);
+        fill(val, aligned - m_curPos);
+    }
+};
+
+template<std::endian Order>
+class EndianWriter : public BasicWriter<EndianWriter<Order>>
+{
+public:
+    EndianWriter(std::vector<uint8_t>& data, uint32_t pos = 0, DirtyRanges* dirty = nullptr)
+            : BasicWriter<EndianWriter<Order>>(data, pos, dirty) {}
+
+    static constexpr bool needsSwap() { return Order != std::endian::native; }
+};
+
+typedef EndianWriter<std::endian::big> BigEndianWriter;
+
+class ByteWriter : public BasicWriter<ByteWriter>
+{
+    bool m_bigEndian = true;
+
+public:
+    ByteWriter(std::vector<uint8_t>& data, bool bigEndian = true, uint32_t pos = 0, DirtyRanges* dirty = nullptr)
+            : BasicWriter<ByteWriter>(data, pos, dirty), m_bigEndian(bigEndian) {}
+
+    bool needsSwap() const { return m_bigEndian != ByteSwap::NATIVE_BIG; }
+};
@@ -2,19 +2,15 @@
 #include "io/BaseFile.h"
 
 #include <QString>
-#include <QFile>
 
 class ExternalFile : public BaseFile
 {
     QString m_filePath;
 
-    QFile m_file;
+    bool map();
 public:
     ExternalFile(const QString& filePath);
 
     virtual void save() override;
     virtual void close() override;
-
-    virtual uint32_t getLength() const override;
-    virtual void setLength(uint32_t length) override;
 };
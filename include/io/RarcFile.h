@@ -1,7 +1,11 @@
 #pragma once
 #include <QString>
 #include <QStringList>
+#include <QStringView>
 
+#include <memory>
+#include <span>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -12,33 +16,70 @@ class InRarcFile;
 
 class RarcFile
 {
-    static std::string pathToKey(const QString& path);
+    // a path inside the archive without its first component, the root dir, whose name doesn't matter
+    // (it's usually the archive's). it points into the caller's string, UTF-16 or Latin-1
+    struct PathRef {
+        const void* chars;
+        uint32_t length;
+        bool wide;
+
+        char16_t operator[](uint32_t i) const
+        {
+            return wide ? ((const char16_t*) chars)[i] : (uint8_t) ((const char*) chars)[i];
+        }
+    };
+
+    // the index hashes and compares paths case folded on the fly, so looking one up never builds a key
+    struct PathHash {
+        using is_transparent = void;
+
+        size_t operator()(PathRef path) const;
+        size_t operator()(const std::u16string& key) const;
+    };
+
+    struct PathEqual {
+        using is_transparent = void;
+
+        bool operator()(PathRef a, PathRef b) const;
+        bool operator()(PathRef a, const std::u16string& b) const;
+        bool operator()(const std::u16string& a, PathRef b) const;
+        bool operator()(const std::u16string& a, const std::u16string& b) const;
+    };
+
+    static PathRef relativePath(QStringView path);
+    static PathRef relativePath(std::string_view path);
+    static std::u16string pathToKey(QStringView path);
     static uint32_t align32(uint32_t val);
     static uint32_t dirMagic(const QString& name);
     static uint16_t nameHash(const QString& name);
 
 
     QString m_filePath;
-    BaseFile* file;
+    std::shared_ptr<BaseFile> file; // copies of the archive share it
 
     uint32_t m_unk38;
+    bool m_deduplicate = false;
+    bool m_layoutChanged = false; // files or dirs were added, moved or renamed since the last save
 
-    struct DirEntry;
+    static constexpr uint32_t NONE = UINT32_MAX; // no node, e.g. the root's parent
 
     struct FileEntry {
-        DirEntry* parentDir;
+        uint32_t parentDir;
 
         uint32_t dataOffset;
         uint32_t dataSize;
+        uint32_t entryOffset; // where its entry is in the archive
 
         QString name;
         QString fullName;
 
-        std::vector<uint8_t> data;
+        // the file's new bytes once it's been saved back, until then they're in the archive at dataOffset.
+        // set means the file is dirty
+        std::shared_ptr<const std::vector<uint8_t>> data;
     };
 
     struct DirEntry {
-        DirEntry* parentDir;
+        uint32_t parentDir;
 
         QString name;
         QString fullName;
@@ -46,15 +87,72 @@ class RarcFile
         uint32_t tempID;
         uint32_t tempNameOffset;
 
-        std::vector<DirEntry*> childrenDirs;
-        std::vector<FileEntry*> childrenFiles;
+        std::vector<uint32_t> childrenDirs;
+        std::vector<uint32_t> childrenFiles;
     };
 
+    // every node lives in these and links to the others by index, so the tree goes with the archive.
+    // removing a node just unlinks it, its slot stays until then
+    std::vector<DirEntry> m_dirs;
+    std::vector<FileEntry> m_files;
+
+    // pathToKey(fullName) -> index in m_dirs/m_files
+    std::unordered_map<std::u16string, uint32_t, PathHash, PathEqual> dirEntries;
+    std::unordered_map<std::u16string, uint32_t, PathHash, PathEqual> fileEntries;
+
+    // NONE if it isn't there
+    uint32_t findDir(PathRef path) const;
+    uint32_t findFile(PathRef path) const;
+    void rekeyDir(uint32_t dir, const QString& fullName); // moves it and everything in it to a new path
 
-    std::unordered_map<std::string, DirEntry*> dirEntries;
-    std::unordered_map<std::string, FileEntry*> fileEntries;
+    std::span<const uint8_t> fileBytes(const FileEntry& fileEntry) const;
+
+    bool patchInPlace();
+    void rebuild();
 
 public:
+    // files whose bytes are identical to an earlier one's
+    struct DuplicateReport {
+        uint32_t numFiles = 0;
+        uint32_t numDuplicates = 0;
+
+        uint32_t totalSize = 0;
+        uint32_t duplicateSize = 0; // what a deduplicated save leaves out, padding included
+    };
+
+    // the names of a directory's children, read straight out of the tree
+    template<typename Entry>
+    class NameList
+    {
+        const uint32_t* m_begin = nullptr;
+        const uint32_t* m_end = nullptr;
+        const Entry* m_entries = nullptr;
+
+    public:
+        class Iterator
+        {
+            const uint32_t* m_it;
+            const Entry* m_entries;
+
+        public:
+            Iterator(const uint32_t* it, const Entry* entries) : m_it(it), m_entries(entries) {}
+
+            const QString& operator*() const { return m_entries[*m_it].name; }
+            Iterator& operator++() { ++m_it; return *this; }
+            bool operator==(const Iterator& other) const { return m_it == other.m_it; }
+        };
+
+        NameList() = default;
+        NameList(const std::vector<uint32_t>& indices, const std::vector<Entry>& entries)
+                : m_begin(indices.data()), m_end(indices.data() + indices.size()), m_entries(entries.data()) {}
+
+        Iterator begin() const { return Iterator(m_begin, m_entries); }
+        Iterator end() const { return Iterator(m_end, m_entries); }
+
+        uint32_t size() const { return m_end - m_begin; }
+        bool empty() const { return size() == 0; }
+    };
+
     RarcFile() = default;
 
     RarcFile(const QString& rarcFilePath);
@@ -62,22 +160,37 @@ public:
     void save();
     void close();
 
+    uint32_t getLength() const; // of the whole archive, decompressed
+
+    // when on, save() stores identical files once and points all their entries at that copy
+    void setDeduplicate(bool dedup);
+    DuplicateReport findDuplicates() const;
+
+    // paths can be QStrings or Latin-1 std::strings/literals, and are matched ignoring case.
+    // an empty list means the directory doesn't exist (or is empty)
+    NameList<DirEntry> subDirectories(QStringView dirName) const;
+    NameList<DirEntry> subDirectories(std::string_view dirName) const;
+    NameList<FileEntry> files(QStringView dirName) const;
+    NameList<FileEntry> files(std::string_view dirName) const;
+
     QStringList getSubDirectories(const QString& dirName);
-    bool directoryExists(const std::string& dirName);
-    bool directoryExists(const QString& dirName);
+    bool directoryExists(QStringView dirName) const;
+    bool directoryExists(std::string_view dirName) const;
     void mkDir(const QString& parent, const QString& dirName);
     void mvDir(const QString& oldName, const QString& newName);
     void rmDir(const QString& dirName);
 
 
     QStringList getFiles(const QString& dirName);
-    bool fileExists(const std::string& filePath);
-    bool fileExists(const QString& filePath);
+    bool fileExists(QStringView filePath) const;
+    bool fileExists(std::string_view filePath) const;
     void mkFile(const QString& dirName, const QString& fileName);
     void mvFile(const QString& oldPath, const QString& newPath);
     void rmFile(const QString& filePath);
 
     BaseFile* openFile(const QString& filePath);
     std::vector<uint8_t> getFileContents(const QString& filePath);
+    // the file's bytes without copying them. owner keeps them alive, even once the archive is saved or gone
+    std::span<const uint8_t> getFileView(const QString& filePath, std::shared_ptr<const void>& owner);
     void reinsertFile(const InRarcFile& file);
 };
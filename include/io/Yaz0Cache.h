@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+
+// Keeps decompressed Yaz0 files in a local directory between runs, so opening an
+// archive that hasn't changed is just a file mapping. Off until a directory is set.
+class Yaz0Cache
+{
+    static QString m_directory;
+    static qint64 m_sizeLimit;
+    static std::mutex m_lock;
+
+    static QString entryPath(const QString& sourcePath);
+    static void evict();
+
+public:
+    // one version of a source file. size and modification time catch the usual edits,
+    // the hash catches tools that keep the modification time
+    struct Key
+    {
+        QString sourcePath;
+        uint64_t size = 0;
+        int64_t modified = 0;
+        uint64_t contentHash = 0;
+    };
+
+    // an empty directory turns the cache off
+    static void setDirectory(const QString& directory);
+    static QString defaultDirectory();
+    static bool isEnabled();
+
+    // the oldest entries go once the cache grows past this many bytes
+    static void setSizeLimit(qint64 bytes);
+
+    static Key makeKey(const QString& sourcePath, std::span<const uint8_t> compressed);
+
+    // maps the cached data for key. owner keeps the mapping alive
+    static bool find(const Key& key, std::span<const uint8_t>& data, std::shared_ptr<const void>& owner);
+    static void store(const Key& key, std::span<const uint8_t> data);
+};
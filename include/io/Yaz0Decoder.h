@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+// Decodes a Yaz0 stream a piece at a time, picking up where the last call stopped.
+// Lets a file decode only as far as anyone has read, instead of all of it up front.
+class Yaz0Decoder
+{
+    std::span<const uint8_t> m_in;  // the whole stream, header included
+    std::span<uint8_t> m_out;       // exactly as big as the decompressed data
+
+    uint32_t m_inPos = 16;
+    uint32_t m_outPos = 0;
+
+    // the flag byte we're in the middle of
+    uint8_t m_block = 0;
+    uint32_t m_blockLeft = 0;
+
+    bool m_failed = false;
+
+public:
+    Yaz0Decoder(std::span<const uint8_t> in, std::span<uint8_t> out);
+
+    // decodes until at least the first end bytes of the output are there. the last copy may go a bit further.
+    // returns false (without reading or writing out of bounds) if the data is corrupt
+    bool decodeUpTo(uint32_t end);
+
+    // how much of the output is there so far
+    uint32_t decoded() const { return m_outPos; }
+    bool done() const { return m_outPos == m_out.size(); }
+};
@@ -2,28 +2,67 @@
 
 #include "MemoryFile.h"
 #include "ExternalFile.h"
+#include "Yaz0Cache.h"
+#include "Yaz0Decoder.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <vector>
 
 class ExternalFile;
 
 class Yaz0File : public MemoryFile
 {
-    ExternalFile m_backend;
-
-    struct Occurrence
+public:
+    // trades save time for file size
+    enum class Level
     {
-        int32_t offset = -1; // TODO uint?
-        uint32_t length = 0;
+        Store,   // no compression at all, about as fast as a memcpy. handy for quick tests in an emulator
+        Fast,    // greedy matching with one byte of lookahead
+        Optimal  // smallest output, for release builds
     };
 
-    static Occurrence findOccurrence(const std::vector<uint8_t>& data, uint32_t pos);
+private:
+    static Level m_defaultLevel;
+
+    ExternalFile m_backend;
+    Level m_level;
+
+    // the contents are decoded on demand, as far as anyone has asked for so far.
+    // m_decoded is how far that is, so reads that are already covered don't need the lock
+    mutable std::unique_ptr<Yaz0Decoder> m_decoder;
+    mutable std::mutex m_decodeLock;
+    mutable std::atomic<uint32_t> m_decoded = UINT32_MAX;
+    mutable std::optional<Yaz0Cache::Key> m_cacheKey; // set while the decoded contents should go in the cache
+
+    void stopDecoding();
 
 public:
     Yaz0File(QString filePath);
 
+    // the level new files start with
+    static void setDefaultLevel(Level level);
+
+    void setLevel(Level level) { m_level = level; }
+    Level level() const { return m_level; }
+
     void save() override;
 
-    static std::vector<uint8_t> decompress(const std::vector<uint8_t>& data);
-    static std::vector<uint8_t> compress(const std::vector<uint8_t>& data);
+    void ensureLoaded(uint32_t end) const override;
+    void setContents(const std::vector<uint8_t>& bytes) override;
+    void setContents(std::vector<uint8_t>&& bytes) override;
+
+    static bool isCompressed(std::span<const uint8_t> data);
+    // what the data decompresses to, or its own size if it isn't compressed
+    static uint32_t decompressedSize(std::span<const uint8_t> data);
+
+    // throws std::runtime_error if the data is corrupt
+    static std::vector<uint8_t> decompress(std::span<const uint8_t> data);
+    // decodes into a buffer of at least decompressedSize(data) bytes.
+    // returns false (without reading or writing out of bounds) if the data is corrupt
+    static bool decompress(std::span<const uint8_t> data, std::span<uint8_t> out);
+    static std::vector<uint8_t> compress(std::span<const uint8_t> data, Level level = Level::Fast);
 };
@@ -830,7 +830,7 @@ struct VertexArray
     CompType_t compType;
     CompCnt_t compCnt;
     uint8_t compShift;
-    std::span<uint8_t> buffer;
+    std::span<const uint8_t> buffer;
     uint32_t dataOffset;
     uint32_t dataSize;
 };
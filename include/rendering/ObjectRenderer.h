@@ -5,6 +5,7 @@
 #include "rendering/Texture.h"
 #include "rendering/GX.h"
 
+#include <memory>
 #include <vector>
 #include <future>
 
@@ -18,8 +19,7 @@ struct DrawCall
 
 class ObjectRenderer
 {
-    BmdFile m_model;
-    RarcFile m_rarc;
+    std::shared_ptr<BmdFile> m_model; // shared with every other object using the same model
 
     BaseObject* m_object;
     std::vector<Texture> m_textures;
@@ -13,12 +13,15 @@ protected:
     QString m_dir, m_layer, m_fileName;
     //QString m_type = "general";
     //QString m_oldName; // TODO what is this?
-    BcsvFile::Entry& m_data;
+    BcsvFile::Entry m_data; // a view of its row, which keeps the table it came from alive
     int32_t m_ID = -1;
 
     glm::vec3 m_pos, m_rot, m_scl;
 
     friend class ObjectRenderer;
+
+    // writes the name, position, rotation and scale back into m_data
+    void savePlacement();
 public:
 
     QString m_name;
@@ -0,0 +1,161 @@
+#include "io/ArchiveCache.h"
+
+#include "io/BmdFile.h"
+#include "io/RarcFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+std::unordered_map<std::string, ArchiveCache::Entry> ArchiveCache::m_entries;
+uint64_t ArchiveCache::m_memoryBudget = 256 * 1024 * 1024;
+uint64_t ArchiveCache::m_memoryUsed = 0;
+uint64_t ArchiveCache::m_clock = 0;
+std::mutex ArchiveCache::m_lock;
+std::mutex ArchiveCache::m_openLock;
+
+template<typename T, typename Load>
+std::shared_ptr<T> ArchiveCache::get(const std::string& key, Load load)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    auto it = m_entries.find(key);
+    if(it != m_entries.end())
+    {
+        it->second.lastUse = ++m_clock;
+
+        // might still be loading on another thread, in which case this waits for it
+        std::shared_future<std::shared_ptr<void>> value = it->second.value;
+        lock.unlock();
+
+        return std::static_pointer_cast<T>(value.get());
+    }
+
+    // claim the entry before loading, so anyone else asking for it waits on this load instead of starting their own
+    std::promise<std::shared_ptr<void>> promise;
+    m_entries[key].value = promise.get_future().share();
+    lock.unlock();
+
+    uint64_t size = 0;
+    std::shared_ptr<T> ret;
+
+    try
+    {
+        ret = load(size);
+    }
+    catch(...)
+    {
+        // whoever's waiting gets the error too, and the next request tries again
+        promise.set_exception(std::current_exception());
+
+        lock.lock();
+        m_entries.erase(key);
+        throw;
+    }
+
+    promise.set_value(ret);
+
+    lock.lock();
+
+    Entry& entry = m_entries[key];
+    entry.loaded = true;
+    entry.size = size;
+    entry.lastUse = ++m_clock;
+    m_memoryUsed += size;
+
+    evict(m_memoryBudget);
+
+    return ret;
+}
+
+void ArchiveCache::evict(uint64_t budget)
+{
+    // dropping a model can leave its archive unused, so go again until nothing else can go
+    bool dropped = true;
+    while(dropped && m_memoryUsed > budget)
+    {
+        dropped = false;
+
+        // only what's loaded and held by nobody but us can go, oldest first
+        std::vector<std::pair<uint64_t, std::string>> candidates;
+        for(auto& [key, entry] : m_entries)
+        {
+            if(entry.loaded && entry.value.get().use_count() == 1)
+                candidates.push_back({ entry.lastUse, key });
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+
+        for(auto& [lastUse, key] : candidates)
+        {
+            if(m_memoryUsed <= budget)
+                break;
+
+            auto it = m_entries.find(key);
+            m_memoryUsed -= it->second.size;
+            m_entries.erase(it);
+            dropped = true;
+        }
+    }
+}
+
+std::shared_ptr<RarcFile> ArchiveCache::archive(const QString& path)
+{
+    return get<RarcFile>(path.toStdString(), [&](uint64_t& size)
+    {
+        std::shared_ptr<RarcFile> rarc = std::make_shared<RarcFile>(path);
+        size = rarc->getLength();
+        return rarc;
+    });
+}
+
+std::shared_ptr<BmdFile> ArchiveCache::model(const QString& archivePath, const QString& modelPath)
+{
+    // can't be mistaken for an archive, those all end in .arc
+    std::string key = archivePath.toStdString() + modelPath.toLower().toStdString();
+
+    return get<BmdFile>(key, [&](uint64_t& size)
+    {
+        std::shared_ptr<RarcFile> rarc = archive(archivePath);
+
+        // opening reads the archive's state, so models of the same archive take turns here. parsing doesn't
+        BaseFile* file;
+        {
+            std::lock_guard<std::mutex> lock(m_openLock);
+            file = rarc->openFile(modelPath);
+        }
+
+        if(file == nullptr)
+            throw std::runtime_error("ArchiveCache: no model " + modelPath.toStdString() + " in " + archivePath.toStdString());
+
+        // the file goes with the model, or right away if parsing it fails
+        std::unique_ptr<BaseFile> owned(file);
+        BmdFile* parsed = new BmdFile(file);
+        owned.release();
+
+        // the model owns its file, and holds on to the archive for as long as it's around.
+        // the model's bytes are a view of the archive's, which is already counted
+        std::shared_ptr<BmdFile> model(parsed, [rarc, file](BmdFile* model)
+        {
+            delete model;
+            delete file;
+        });
+
+        size = model->memorySize();
+        return model;
+    });
+}
+
+void ArchiveCache::setMemoryBudget(uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_memoryBudget = bytes;
+    evict(m_memoryBudget);
+}
+
+void ArchiveCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    evict(0);
+}
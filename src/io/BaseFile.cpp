@@ -1,8 +1,44 @@
 #include "io/BaseFile.h"
 
+#include "io/ByteStrings.h"
+
 #include <QString>
-#include <QTextCodec>
+#include <algorithm>
 #include <array>
+#include <cstring>
+
+void BaseFile::borrow(std::span<const uint8_t> bytes, std::shared_ptr<const void> owner)
+{
+    m_contents.clear();
+    m_contents.shrink_to_fit();
+
+    m_view = bytes;
+    m_viewOwner = std::move(owner);
+}
+
+bool BaseFile::isBorrowed() const
+{
+    return m_viewOwner != nullptr;
+}
+
+void BaseFile::makeWritable()
+{
+    ensureLoaded(m_view.size());
+    m_unsaved = true;
+
+    if(!isBorrowed())
+        return;
+
+    m_contents.assign(m_view.begin(), m_view.end());
+    m_view = m_contents;
+    m_viewOwner.reset(); // might unmap the file, so do this last
+}
+
+void BaseFile::markSaved()
+{
+    m_dirty.clear();
+    m_unsaved = false;
+}
 
 void BaseFile::setBigEndian(bool big)
 {
@@ -26,239 +62,236 @@ void BaseFile::skip(uint32_t count)
 
 uint32_t BaseFile::getLength() const
 {
-    return m_contents.size();
+    return m_view.size();
 }
 
 void BaseFile::setLength(uint32_t length)
 {
+    makeWritable();
+
     m_contents.resize(length);
+    m_view = m_contents;
 }
 
 
-uint8_t BaseFile::readByte() const
-{
-    return m_contents[m_curPos++]; // post-increment
-}
-
-uint16_t BaseFile::readShort() const
+// BaseFile's reads are a ByteReader at m_curPos that moves m_curPos along when it's done.
+// it only sees the bytes up to the end of the read, so a file that loads lazily only loads that far
+struct BaseFile::ReadCursor
 {
-    uint16_t ret = 0;
+    const BaseFile& file;
+    ByteReader reader;
 
-    if(m_bigEndian)
-    {
-        ret |= readByte() << 8;
-        ret |= readByte() << 0;
-    }
-    else
+    static std::span<const uint8_t> loaded(const BaseFile& f, uint32_t end)
     {
-        ret |= readByte() << 0;
-        ret |= readByte() << 8;
+        end = std::min<uint32_t>(end, f.m_view.size());
+        f.ensureLoaded(end);
+
+        return f.m_view.first(end);
     }
 
-    return ret;
-}
+    ReadCursor(const BaseFile& f, uint32_t count)
+            : file(f), reader(loaded(f, f.m_curPos + count), f.m_bigEndian, f.m_curPos) {}
+    ~ReadCursor() { file.m_curPos = reader.position(); }
+};
 
-int16_t BaseFile::readShortS() const
+ByteReader BaseFile::reader(uint32_t offset) const
 {
-    int16_t ret = 0;
-
-    uint8_t insignificantByte = readByte();
-    uint8_t significantByte   = readByte();
-
-    if(m_bigEndian)
-    {
-        uint8_t temp = insignificantByte;
-        insignificantByte = significantByte;
-        significantByte = temp;
-    }
-
-    ret |= significantByte   << 7;
-    ret |= insignificantByte << 0;
+    return ByteReader(getContents(), m_bigEndian, offset);
+}
 
-    if(significantByte >> 7)
-        ret *= -1;
+uint8_t BaseFile::readByte() const
+{
+    return ReadCursor(*this, 1).reader.readByte();
+}
 
-    return ret;
+uint16_t BaseFile::readShort() const
+{
+    return ReadCursor(*this, 2).reader.readShort();
 }
 
+int16_t BaseFile::readShortS() const
+{
+    return ReadCursor(*this, 2).reader.readShortS();
+}
 
 uint32_t BaseFile::readInt() const
 {
-    uint32_t ret = 0;
-
-    if(m_bigEndian)
-    {
-        ret |= readByte() << 24;
-        ret |= readByte() << 16;
-        ret |= readByte() <<  8;
-        ret |= readByte() <<  0;
-    }
-    else
-    {
-        ret |= readByte() <<  0;
-        ret |= readByte() <<  8;
-        ret |= readByte() << 16;
-        ret |= readByte() << 24;
-    }
-
-    return ret;
+    return ReadCursor(*this, 4).reader.readInt();
 }
 
 float BaseFile::readFloat() const
 {
-    // oh boy
-    float ret;
-
-    uint8_t bytes[] = {readByte(), readByte(), readByte(), readByte()};
-
-    // hope this works
-    if(!m_bigEndian)
-    {
-        uint8_t temp = bytes[3];
-        bytes[3] = bytes[0];
-        bytes[0] = temp;
-
-        temp = bytes[2];
-        bytes[2] = bytes[1];
-        bytes[1] = temp;
-    }
-
-    memcpy(&ret, &bytes, sizeof(float));
-
-    return ret;
+    return ReadCursor(*this, 4).reader.readFloat();
 }
 
 QString BaseFile::readString(uint32_t length, const char* enc) const
 {
-    if(strcmp(enc, "ASCII") == 0)
-        enc = "UTF-8";
+    if(length != 0)
+        return ReadCursor(*this, length).reader.readString(length, enc);
 
-    std::vector<uint8_t> bytes;
-    for(int i = 0; i < length || length == 0; i++)
+    // the terminator could be anywhere, so load a little more at a time until it's there
+    uint32_t chunk = 64;
+    uint32_t end;
+    while(true)
     {
-        uint8_t byte = readByte();
+        end = std::min<uint32_t>(m_curPos + chunk, m_view.size());
+        ensureLoaded(end);
 
-        if(length == 0 && byte == 0)
-        {
-            // TODO will this break on multibyte encs like Shift-JIS?
+        if(end == m_view.size() || memchr(m_view.data() + m_curPos, 0, end - m_curPos) != nullptr)
             break;
-        }
-
-        bytes.push_back(byte);
-
 
+        chunk *= 2;
     }
 
-    const QByteArray byteArray = QByteArray::fromRawData((const char*)bytes.data(), bytes.size());
-
-    QTextDecoder* dc = QTextCodec::codecForName(enc)->makeDecoder();
-    return dc->toUnicode(byteArray);
+    return ReadCursor(*this, end - m_curPos).reader.readString(0, enc);
 }
 
 std::vector<uint8_t> BaseFile::readBytes(uint32_t count) const
 {
-    std::vector<uint8_t> ret(count);
-
-    for(int i = 0; i < count; i++)
-        ret[i] = readByte();
+    return ReadCursor(*this, count).reader.readBytes(count);
+}
 
-    return ret;
+void BaseFile::readBytes(std::span<uint8_t> out) const
+{
+    ReadCursor(*this, out.size()).reader.readBytes(out);
 }
 
-void BaseFile::writeByte(uint8_t val)
+void BaseFile::readShorts(std::span<uint16_t> out) const
 {
-    uint8_t oldVal = m_contents[m_curPos];
+    ReadCursor(*this, out.size_bytes()).reader.readShorts(out);
+}
 
-    m_contents[m_curPos++] = val;
+void BaseFile::readInts(std::span<uint32_t> out) const
+{
+    ReadCursor(*this, out.size_bytes()).reader.readInts(out);
+}
 
-    if(oldVal != val)
-        m_modifiedFlag = true;
+void BaseFile::readFloats(std::span<float> out) const
+{
+    ReadCursor(*this, out.size_bytes()).reader.readFloats(out);
 }
 
-void BaseFile::writeShort(uint16_t val)
+// and writes are a ByteWriter into m_contents, which grows as needed
+struct BaseFile::WriteCursor
 {
-    if(m_bigEndian)
+    BaseFile& file;
+    ByteWriter writer;
+
+    static BaseFile& writable(BaseFile& f)
     {
-        writeByte(val >> 8 & 0xFF);
-        writeByte(val      & 0xFF);
+        f.makeWritable();
+        return f;
     }
-    else
+
+    WriteCursor(BaseFile& f)
+            : file(writable(f)), writer(f.m_contents, f.m_bigEndian, f.m_curPos, &f.m_dirty) {}
+
+    ~WriteCursor()
     {
-        writeByte(val      & 0xFF);
-        writeByte(val >> 8 & 0xFF);
+        file.m_curPos = writer.position();
+        file.m_view = file.m_contents; // might have been reallocated
     }
+};
+
+void BaseFile::writeByte(uint8_t val)
+{
+    WriteCursor(*this).writer.writeByte(val);
+}
+
+void BaseFile::writeShort(uint16_t val)
+{
+    WriteCursor(*this).writer.writeShort(val);
 }
 
 void BaseFile::writeInt(uint32_t val)
 {
-    if(m_bigEndian)
-    {
-        writeByte(val >> 24 & 0xFF);
-        writeByte(val >> 16 & 0xFF);
-        writeByte(val >> 8  & 0xFF);
-        writeByte(val       & 0xFF);
-    }
-    else
-    {
-        writeByte(val       & 0xFF);
-        writeByte(val >> 8  & 0xFF);
-        writeByte(val >> 16 & 0xFF);
-        writeByte(val >> 24 & 0xFF);
-    }
+    WriteCursor(*this).writer.writeInt(val);
 }
 
 void BaseFile::writeFloat(float val)
 {
-    union U {
-        float val;
-        std::array<uint8_t, sizeof(float)> bytes;
-    } u;
+    WriteCursor(*this).writer.writeFloat(val);
+}
 
-    u.val = val;
+int BaseFile::writeString(const QString& str, const char* enc)
+{
+    return WriteCursor(*this).writer.writeString(str, enc);
+}
 
-    if(m_bigEndian)
-    {
-        writeByte(u.bytes[0]);
-        writeByte(u.bytes[1]);
-        writeByte(u.bytes[2]);
-        writeByte(u.bytes[3]);
-    }
-    else
-    {
-        writeByte(u.bytes[3]);
-        writeByte(u.bytes[2]);
-        writeByte(u.bytes[1]);
-        writeByte(u.bytes[0]);
-    }
+void BaseFile::writeBytes(std::span<const uint8_t> bytes)
+{
+    WriteCursor(*this).writer.writeBytes(bytes);
 }
 
+void BaseFile::writeShorts(std::span<const uint16_t> vals)
+{
+    WriteCursor(*this).writer.writeShorts(vals);
+}
 
-int BaseFile::writeString(const QString& str, const char* enc)
+void BaseFile::writeInts(std::span<const uint32_t> vals)
 {
-    if(strcmp(enc, "ASCII") == 0)
-        enc = "UTF-8";
+    WriteCursor(*this).writer.writeInts(vals);
+}
 
-    QTextEncoder* en = QTextCodec::codecForName(enc)->makeEncoder();
-    QByteArray strBytes = en->fromUnicode(str);
+void BaseFile::writeFloats(std::span<const float> vals)
+{
+    WriteCursor(*this).writer.writeFloats(vals);
+}
 
-    for(auto& byte : strBytes)
-        writeByte(byte);
+bool BaseFile::isModified() const
+{
+    return m_unsaved || !m_dirty.empty();
+}
 
-    return strBytes.length();
+const DirtyRanges& BaseFile::dirtyRanges() const
+{
+    return m_dirty;
+}
+
+void BaseFile::ensureLoaded(uint32_t) const
+{
+    // everything is always there
 }
 
-void BaseFile::writeBytes(const std::vector<uint8_t>& bytes)
+std::span<const uint8_t> BaseFile::getContents() const
 {
-    for(auto& byte : bytes)
-        writeByte(byte);
+    ensureLoaded(m_view.size());
+    return m_view;
 }
 
-const std::vector<uint8_t>& BaseFile::getContents() const
+std::shared_ptr<const void> BaseFile::shareContents()
 {
-    return m_contents;
+    // move our own bytes into a shared buffer and borrow that instead. the vector's storage
+    // moves with it, so spans already handed out stay where they are
+    if(!isBorrowed())
+    {
+        auto shared = std::make_shared<const std::vector<uint8_t>>(std::move(m_contents));
+        borrow(*shared, shared);
+    }
+
+    return m_viewOwner;
 }
 
 void BaseFile::setContents(const std::vector<uint8_t>& bytes)
 {
     m_contents = bytes;
+    m_view = m_contents;
+    m_viewOwner.reset();
+    m_dirty.clear();
+    m_unsaved = true;
+}
+
+void BaseFile::setContents(std::vector<uint8_t>&& bytes)
+{
+    m_contents = std::move(bytes);
+    m_view = m_contents;
+    m_viewOwner.reset();
+    m_dirty.clear();
+    m_unsaved = true;
+}
+
+std::span<const uint8_t> BaseFile::slice(uint32_t start, uint32_t end) const
+{
+    ensureLoaded(end);
+    return m_view.subspan(start, end - start);
 }
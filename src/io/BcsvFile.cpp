@@ -1,81 +1,69 @@
 #include "io/BcsvFile.h"
 
+#include "io/ByteStrings.h"
+#include "io/ByteSwap.h"
+
 #include <QHash>
 
-BcsvFile::BcsvFile(BaseFile* inRarcFile) : file(inRarcFile)
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+BcsvFile::BcsvFile(BaseFile* inRarcFile, bool lazy) : file(inRarcFile)
 {
-    uint32_t entryCount = file->readInt();
-    uint32_t fieldCount = file->readInt();
-    uint32_t dataOffset = file->readInt();
-    uint32_t entryDataSize = file->readInt();
+    BigEndianReader reader(file->getContents());
+
+    uint32_t entryCount = reader.readInt();
+    uint32_t fieldCount = reader.readInt();
+    uint32_t dataOffset = reader.readInt();
+    uint32_t entryDataSize = reader.readInt();
 
     uint32_t stringTableOffset = dataOffset + (entryCount * entryDataSize);
 
     for(int i = 0; i < fieldCount; i++)
     {
-        file->position(0x10 + 0xC * i);
+        reader.position(0x10 + 0xC * i);
 
         Field field {
-            file->readInt(),   // nameHash
-            file->readInt(),   // mask
-            file->readShort(), // entryOffset
-            file->readByte(),  // shiftAmount
-            file->readByte(),  // type
+            reader.readInt(),   // nameHash
+            reader.readInt(),   // mask
+            reader.readShort(), // entryOffset
+            reader.readByte(),  // shiftAmount
+            reader.readByte(),  // type
             BcsvFile::hashToFieldName(field.nameHash)
         };
 
         m_fields.push_back(field);
     }
 
-    for(int i = 0; i < entryCount; i++)
-    {
-        Entry entry;
+    m_table = std::make_shared<Table>();
+    m_table->numRows = entryCount;
+    m_table->source = Source { file->getContents(), nullptr, dataOffset, entryDataSize, stringTableOffset, {} };
 
-        for(const Field& field : m_fields)
-        {
-            file->position(dataOffset + (i * entryDataSize) + field.entryOffset);
-
-            Value val;
-            switch(field.type) {
-                case 0:
-                case 3:
-                {
-                    val = uint32_t((file->readInt() & field.mask) >> field.shift);
-                    break;
-                }
-                case 4:
-                {
-                    val = uint16_t((file->readShort() & field.mask) >> field.shift);
-                    break;
-                }
-                case 5:
-                {
-                    val = uint8_t((file->readByte() * field.mask) >> field.shift);
-                    break;
-                }
-                case 2:
-                {
-                    val = file->readFloat();
-                    break;
-                }
-                case 6:
-                {
-                    int strOffset = file->readInt();
-                    file->position(stringTableOffset + strOffset);
-                    val = file->readString(0, "Shift-JIS");
-                    break;
-                }
-                default:
-                {
-                    assert(false); // Bcsv: unsupported data type
-                }
-            }
+    // a lazy table holds on to the bytes, which stay put even if the file is written to or closed
+    if(lazy)
+        m_table->source->owner = file->shareContents();
 
-            entry.insert(field.nameHash, val);
-        }
+    m_table->columns.reserve(fieldCount);
+    for(const Field& field : m_fields)
+        m_table->columns.push_back(Column { field.nameHash, {}, field });
+
+    // every column starts out pending, an eager table just decodes them all right away
+    m_table->numPending = fieldCount;
 
-        m_entries.emplace_back(entry);
+    if(!lazy)
+    {
+        for(Column& column : m_table->columns)
+            m_table->decode(column);
+
+        assert(m_table->numPending == 0); // Bcsv: every column should be decoded
+        m_table->source.reset();
     }
+
+    m_entries.reserve(entryCount);
+    for(uint32_t i = 0; i < entryCount; i++)
+        m_entries.emplace_back(m_table, i);
 }
 
 void BcsvFile::save()
@@ -96,101 +84,148 @@ void BcsvFile::save()
     uint32_t dataOffset = 0x10 + (0xC * m_fields.size());
     uint32_t stringTableOffset = dataOffset + (entrySize * m_entries.size());
 
-    uint32_t curString = 0;
+    // the whole file is built in one buffer. the rows start zeroed and every field is OR-ed into its bits
+    std::vector<uint8_t> out(stringTableOffset);
+    BigEndianWriter writer(out);
 
-    file->setLength(stringTableOffset);
-    file->writeInt(m_entries.size());
-    file->writeInt(m_fields.size());
-    file->writeInt(dataOffset);
-    file->writeInt(entrySize);
+    writer.writeInt(m_entries.size());
+    writer.writeInt(m_fields.size());
+    writer.writeInt(dataOffset);
+    writer.writeInt(entrySize);
 
     for(const Field& field : m_fields)
     {
-        file->writeInt(field.nameHash);
-        file->writeInt(field.mask);
-        file->writeShort(field.entryOffset);
-        file->writeByte(field.shift);
-        file->writeByte(field.type);
+        writer.writeInt(field.nameHash);
+        writer.writeInt(field.mask);
+        writer.writeShort(field.entryOffset);
+        writer.writeByte(field.shift);
+        writer.writeByte(field.type);
     }
 
-    int i = 0;
-    std::unordered_map<QString, int> stringOffsets;
+    auto lock = m_table->lockIfPending();
+
+    // the file's own rows read its columns, found once (which decodes any still pending).
+    // rows from elsewhere (new objects) look up theirs
+    std::vector<Column*> ownColumns;
+    std::vector<Column*> columns(m_fields.size());
+    for(const Field& field : m_fields)
+        ownColumns.push_back(m_table->find(field.nameHash));
 
+    // every distinct string goes in the string table once. the file's own strings are looked up by id,
+    // only the ones from rows that came from elsewhere get hashed
+    std::vector<uint8_t> stringTable;
+    std::unordered_map<QString, uint32_t> stringOffsets;
+    stringOffsets.reserve(m_table->strings.size());
+
+    std::vector<uint32_t> ownStringOffsets(m_table->strings.size(), UINT32_MAX);
+
+    auto addString = [&](const QString& str)
+    {
+        auto [it, added] = stringOffsets.try_emplace(str, stringTable.size());
+        if(added)
+        {
+            QByteArray bytes = ByteStrings::encode(str, "Shift-JIS");
+            stringTable.insert(stringTable.end(), bytes.constData(), bytes.constData() + bytes.length());
+            stringTable.push_back(0);
+        }
+
+        return it->second;
+    };
+
+    // ORs a value that's already big-endian into the row
+    auto orInto = [](uint8_t* dst, auto bits)
+    {
+        decltype(bits) cur;
+        memcpy(&cur, dst, sizeof(cur));
+        cur |= bits;
+        memcpy(dst, &cur, sizeof(cur));
+    };
+
+    auto toBig32 = [](uint32_t val) { return ByteSwap::NATIVE_BIG ? val : ByteSwap::swap32(val); };
+    auto toBig16 = [](uint16_t val) { return ByteSwap::NATIVE_BIG ? val : ByteSwap::swap16(val); };
+
+    uint8_t* row = out.data() + dataOffset;
     for(const Entry& entry : m_entries)
     {
-        for(const Field& field : m_fields)
+        Table* table = entry.m_table.get();
+        bool own = (table == m_table.get());
+
+        std::unique_lock<std::mutex> rowLock;
+        if(!own && table != nullptr)
+            rowLock = table->lockIfPending();
+
+        if(!own)
         {
-            uint32_t valOffset = dataOffset + (i * entrySize) + field.entryOffset;
-            file->position(valOffset);
+            for(size_t f = 0; f < m_fields.size(); f++)
+                columns[f] = (table != nullptr) ? table->find(m_fields[f].nameHash) : nullptr;
+        }
+
+        Column* const* rowColumns = own ? ownColumns.data() : columns.data();
+
+        for(size_t f = 0; f < m_fields.size(); f++)
+        {
+            const Field& field = m_fields[f];
+            const Column* column = rowColumns[f];
+
+            // a field the row doesn't have stays zero
+            if(column == nullptr)
+                continue;
+
+            uint8_t* dst = row + field.entryOffset;
 
             switch(field.type)
             {
             case 0:
             case 3:
             {
-                uint32_t val = file->readInt();
-                val &= ~field.mask;
-                val |= (std::get<uint32_t>(entry[field.nameHash]) << field.shift) & field.mask;
-
-                file->position(valOffset);
-                file->writeInt(val);
+                uint32_t val = std::get<std::vector<uint32_t>>(column->values)[entry.m_row];
+                orInto(dst, toBig32((val << field.shift) & field.mask));
                 break;
             }
             case 4:
             {
-                uint16_t val = file->readShort();
-                val &= ~field.mask;
-                val |= (std::get<uint16_t>(entry[field.nameHash]) << field.shift) & field.mask;
-
-                file->position(valOffset);
-                file->writeShort(val);
+                uint16_t val = std::get<std::vector<uint16_t>>(column->values)[entry.m_row];
+                orInto(dst, toBig16(uint16_t((val << field.shift) & field.mask)));
                 break;
             }
             case 5:
             {
-                uint8_t val = file->readShort();
-                val &= ~field.mask;
-                val |= (entry.gets(field.nameHash) << field.shift) & field.mask;
-
-                file->position(valOffset);
-                file->writeByte(val);
+                uint8_t val = std::get<std::vector<uint8_t>>(column->values)[entry.m_row];
+                orInto(dst, uint8_t((val << field.shift) & field.mask));
                 break;
             }
             case 2:
             {
-                file->writeFloat(entry.getf(field.nameHash));
+                float val = std::get<std::vector<float>>(column->values)[entry.m_row];
+                orInto(dst, toBig32(std::bit_cast<uint32_t>(val)));
                 break;
             }
             case 6:
             {
-                QString val = std::get<QString>(entry[field.nameHash]);
-                if(stringOffsets.find(val) != stringOffsets.end())
-                {
-                    file->writeInt(stringOffsets[val]);
-                }
+                uint32_t id = uint32_t(std::get<std::vector<StringId>>(column->values)[entry.m_row]);
+
+                uint32_t offset;
+                if(!own)
+                    offset = addString(table->strings[id]);
+                else if(ownStringOffsets[id] != UINT32_MAX)
+                    offset = ownStringOffsets[id];
                 else
-                {
-                    stringOffsets[val] = curString;
-                    file->writeInt(curString);
-                    file->position(stringTableOffset + curString);
-                    curString += file->writeString(val, "Shift-JIS");
-                }
+                    offset = ownStringOffsets[id] = addString(table->strings[id]);
 
+                orInto(dst, toBig32(offset));
                 break;
             }
             }
-
         }
 
-        i++;
+        row += entrySize;
     }
 
-    i = file->getLength();
-    file->position(i);
-    int alignedEnd = (i + 0x1F) & ~0x1F;
-    for(; i < alignedEnd; i++)
-        file->writeByte(0x40);
+    writer.position(stringTableOffset);
+    writer.writeBytes(stringTable);
+    writer.align(0x20, 0x40);
 
+    file->setContents(std::move(out));
     file->save();
 }
 
@@ -209,8 +244,10 @@ BcsvFile::Field BcsvFile::addField(const QString& name, uint32_t mask, uint16_t
         shift = 0;
     }
 
+    // goes after the last field
     if(offset == MAX_U16)
     {
+        offset = 0;
         for(const Field& field : m_fields)
         {
             uint16_t fieldEnd = field.entryOffset + Field::dataSizes[field.type];
@@ -231,8 +268,12 @@ BcsvFile::Field BcsvFile::addField(const QString& name, uint32_t mask, uint16_t
 
     m_fields.push_back(newField);
 
-    for(Entry& entry : m_entries)
-        entry[name] = defaultValue;
+    // every row shares the table, so the new column is all it takes
+    auto lock = m_table->lockIfPending();
+
+    assert(m_table->find(newField.nameHash) == nullptr); // Bcsv: field already exists
+    assert(defaultValue.index() == valueIndex(type)); // Bcsv: default doesn't match the field's type
+    m_table->addColumn(newField.nameHash, defaultValue);
 
     return newField;
 }
@@ -244,8 +285,181 @@ void BcsvFile::removeField(const QString& name)
     // delete the field with this hash
     std::erase_if(m_fields, [&](const Field& f) { return f.nameHash == hash;});
 
-    for(Entry& entry : m_entries)
-        entry.erase(hash);
+    auto lock = m_table->lockIfPending();
+    std::erase_if(m_table->columns, [&](const Column& c)
+    {
+        if(c.nameHash != hash)
+            return false;
+
+        if(c.pending)
+            m_table->numPending--;
+
+        return true;
+    });
+}
+
+uint32_t BcsvFile::valueIndex(uint8_t type)
+{
+    switch(type)
+    {
+        case 0:
+        case 3: return 0;
+        case 4: return 1;
+        case 5: return 2;
+        case 2: return 3;
+        case 6: return 4;
+    }
+
+    assert(false); // Bcsv: unsupported data type
+    return 0;
+}
+
+std::unique_lock<std::mutex> BcsvFile::Table::lockIfPending()
+{
+    // once it's zero it stays zero, and the decoding that got it there happened before this load
+    if(numPending.load(std::memory_order_acquire) == 0)
+        return std::unique_lock<std::mutex>();
+
+    return std::unique_lock<std::mutex>(decodeLock);
+}
+
+BcsvFile::Column* BcsvFile::Table::find(uint32_t nameHash)
+{
+    // tables have a few dozen fields at most, a scan beats hashing
+    for(Column& column : columns)
+    {
+        if(column.nameHash != nameHash)
+            continue;
+
+        if(column.pending)
+            decode(column);
+
+        return &column;
+    }
+
+    return nullptr;
+}
+
+void BcsvFile::Table::decode(Column& column)
+{
+    assert(source); // Bcsv: the column's bytes are gone
+
+    const Field& field = *column.pending;
+    BigEndianReader reader(source->bytes);
+
+    // the whole column in a single pass down the rows
+    auto fill = [&](auto& values, auto read)
+    {
+        values.resize(numRows);
+        for(uint32_t i = 0; i < numRows; i++)
+        {
+            reader.position(source->dataOffset + (i * source->entrySize) + field.entryOffset);
+            values[i] = read();
+        }
+    };
+
+    switch(field.type) {
+        case 0:
+        case 3:
+        {
+            fill(column.values.emplace<std::vector<uint32_t>>(), [&] { return (reader.readInt() & field.mask) >> field.shift; });
+            break;
+        }
+        case 4:
+        {
+            fill(column.values.emplace<std::vector<uint16_t>>(), [&] { return uint16_t((reader.readShort() & field.mask) >> field.shift); });
+            break;
+        }
+        case 5:
+        {
+            fill(column.values.emplace<std::vector<uint8_t>>(), [&] { return uint8_t((reader.readByte() & field.mask) >> field.shift); });
+            break;
+        }
+        case 2:
+        {
+            fill(column.values.emplace<std::vector<float>>(), [&] { return reader.readFloat(); });
+            break;
+        }
+        case 6:
+        {
+            // strings are decoded once per offset, however many rows (or columns) point at them
+            fill(column.values.emplace<std::vector<StringId>>(), [&]
+            {
+                uint32_t strOffset = reader.readInt();
+
+                auto it = source->stringsAt.find(strOffset);
+                if(it != source->stringsAt.end())
+                    return it->second;
+
+                reader.position(source->stringTableOffset + strOffset);
+                StringId id = intern(reader.readString(0, "Shift-JIS"));
+                source->stringsAt.insert(std::make_pair(strOffset, id));
+
+                return id;
+            });
+            break;
+        }
+        default:
+        {
+            assert(false); // Bcsv: unsupported data type
+        }
+    }
+
+    column.pending.reset();
+    numPending.fetch_sub(1, std::memory_order_release);
+}
+
+BcsvFile::Column& BcsvFile::Table::addColumn(uint32_t nameHash, const Value& fill)
+{
+    Column& column = columns.emplace_back();
+    column.nameHash = nameHash;
+
+    std::visit([&](const auto& val)
+    {
+        typedef std::decay_t<decltype(val)> T;
+
+        if constexpr(std::is_same_v<T, QString>)
+            column.values = std::vector<StringId>(numRows, intern(val));
+        else
+            column.values = std::vector<T>(numRows, val);
+    }, fill);
+
+    return column;
+}
+
+BcsvFile::StringId BcsvFile::Table::intern(const QString& str)
+{
+    auto [it, added] = stringIds.try_emplace(str, strings.size());
+    if(added)
+        strings.push_back(str);
+
+    return StringId(it->second);
+}
+
+BcsvFile::Value BcsvFile::Table::get(const Column& column, uint32_t row) const
+{
+    return std::visit([&](const auto& values) -> Value
+    {
+        if constexpr(std::is_same_v<std::decay_t<decltype(values)>, std::vector<StringId>>)
+            return strings[uint32_t(values[row])];
+        else
+            return values[row];
+    }, column.values);
+}
+
+void BcsvFile::Table::set(Column& column, uint32_t row, const Value& val)
+{
+    // alternatives line up, QString with the string ids
+    assert(val.index() == column.values.index()); // Bcsv: value doesn't match the field's type
+
+    switch(val.index())
+    {
+        case 0: std::get<0>(column.values)[row] = std::get<0>(val); break;
+        case 1: std::get<1>(column.values)[row] = std::get<1>(val); break;
+        case 2: std::get<2>(column.values)[row] = std::get<2>(val); break;
+        case 3: std::get<3>(column.values)[row] = std::get<3>(val); break;
+        case 4: std::get<4>(column.values)[row] = intern(std::get<4>(val)); break;
+    }
 }
 
 
@@ -257,15 +471,30 @@ BcsvFile::Value BcsvFile::Entry::operator[](const QString& key) const
 
 BcsvFile::Value BcsvFile::Entry::operator[](uint32_t key) const
 {
-    return m_entry.at(key);
+    if(m_table == nullptr)
+        throw std::out_of_range("Bcsv: no such field");
+
+    auto lock = m_table->lockIfPending();
+
+    Column* column = m_table->find(key);
+    if(column == nullptr)
+        throw std::out_of_range("Bcsv: no such field");
+
+    return m_table->get(*column, m_row);
 }
 
 bool BcsvFile::Entry::contains(const QString& key) const
 {
-    uint32_t hash = fieldNameToHash(key);
-    auto loc = m_entry.find(hash);
+    return contains(fieldNameToHash(key));
+}
 
-    return loc != m_entry.end();
+bool BcsvFile::Entry::contains(uint32_t key) const
+{
+    if(m_table == nullptr)
+        return false;
+
+    auto lock = m_table->lockIfPending();
+    return m_table->find(key) != nullptr;
 }
 
 BcsvFile::Value BcsvFile::Entry::get(const QString& key, BcsvFile::Value defaultValue) const
@@ -275,12 +504,16 @@ BcsvFile::Value BcsvFile::Entry::get(const QString& key, BcsvFile::Value default
 
 BcsvFile::Value BcsvFile::Entry::get(uint32_t key, BcsvFile::Value defaultValue) const
 {
-    auto loc = m_entry.find(key);
+    if(m_table == nullptr)
+        return defaultValue;
 
-    if(loc != m_entry.end())
-        return loc->second;
+    auto lock = m_table->lockIfPending();
 
-    return defaultValue;
+    Column* column = m_table->find(key);
+    if(column == nullptr)
+        return defaultValue;
+
+    return m_table->get(*column, m_row);
 }
 
 uint32_t BcsvFile::Entry::geti(const QString& key, uint32_t defaultValue) const
@@ -335,33 +568,98 @@ QString BcsvFile::Entry::getstr(uint32_t key, const QString& defaultValue) const
 
 void BcsvFile::Entry::insert(const QString& key, const Value& val)
 {
-    m_entry.insert(std::make_pair(fieldNameToHash(key), val));
+    insert(fieldNameToHash(key), val);
 }
 
 void BcsvFile::Entry::insert(uint32_t key, const Value& val)
 {
-    m_entry.insert(std::make_pair(key, val));
+    if(m_table == nullptr)
+    {
+        m_table = std::make_shared<Table>();
+        m_table->numRows = 1;
+        m_row = 0;
+    }
+
+    auto lock = m_table->lockIfPending();
+
+    Column* column = m_table->find(key);
+    if(column == nullptr)
+    {
+        // zero (or an empty string) for the other rows, only this one gets val
+        Value zero = std::visit([](const auto& v) -> Value { return std::decay_t<decltype(v)>(); }, val);
+        column = &m_table->addColumn(key, zero);
+    }
+
+    m_table->set(*column, m_row, val);
 }
 
-void BcsvFile::Entry::erase(const QString& key)
+void BcsvFile::Entry::readFields(std::span<const RecordField> fields, void* record) const
 {
-    uint32_t hash = fieldNameToHash(key);
-    erase(hash);
+    if(m_table == nullptr)
+        return;
+
+    auto lock = m_table->lockIfPending();
+
+    for(const RecordField& field : fields)
+    {
+        Column* column = m_table->find(field.nameHash);
+        if(column == nullptr)
+            continue;
+
+        assert(column->values.index() == valueIndex(field.type)); // Bcsv: record member doesn't match the field's type
+
+        std::visit([&](const auto& values)
+        {
+            typedef typename std::decay_t<decltype(values)>::value_type T;
+
+            // records are plain values, a string can't go in one
+            if constexpr(!std::is_same_v<T, StringId>)
+            {
+                memcpy((uint8_t*) record + field.offset, &values[m_row], sizeof(T));
+            }
+        }, column->values);
+    }
 }
 
-void BcsvFile::Entry::erase(uint32_t key)
+void BcsvFile::Entry::writeFields(std::span<const RecordField> fields, const void* record)
 {
-    m_entry.erase(key);
+    if(m_table == nullptr)
+        return;
+
+    auto lock = m_table->lockIfPending();
+
+    for(const RecordField& field : fields)
+    {
+        Column* column = m_table->find(field.nameHash);
+        if(column == nullptr)
+            continue;
+
+        assert(column->values.index() == valueIndex(field.type)); // Bcsv: record member doesn't match the field's type
+
+        std::visit([&](auto& values)
+        {
+            typedef typename std::decay_t<decltype(values)>::value_type T;
+
+            if constexpr(!std::is_same_v<T, StringId>)
+            {
+                memcpy(&values[m_row], (const uint8_t*) record + field.offset, sizeof(T));
+            }
+        }, column->values);
+    }
 }
 
 
 uint32_t BcsvFile::fieldNameToHash(const QString& fieldName)
 {
+    // names are ASCII, which hashes the same straight from the QString. anything else goes through UTF-8
     uint32_t ret = 0;
-    for(char c : fieldName.toStdString())
+    for(QChar c : fieldName)
     {
+        if(c.unicode() >= 0x80)
+            return fieldHash(fieldName.toStdString());
+
         ret *= 0x1F;
-        ret += c;
+        ret += c.unicode();
     }
 
     return ret;
@@ -0,0 +1,252 @@
+#include "io/BcsvSchema.h"
+
+#include <bit>
+#include <cstddef>
+
+namespace
+{
+    typedef BcsvSchema::Field Field;
+
+    constexpr Field i32(uint32_t nameHash, uint32_t defaultValue, uint8_t game = BcsvSchema::BOTH)
+    {
+        return { nameHash, 0, game, defaultValue, nullptr };
+    }
+
+    constexpr Field i16(uint32_t nameHash, uint16_t defaultValue, uint8_t game = BcsvSchema::BOTH)
+    {
+        return { nameHash, 4, game, defaultValue, nullptr };
+    }
+
+    constexpr Field f32(uint32_t nameHash, float defaultValue, uint8_t game = BcsvSchema::BOTH)
+    {
+        return { nameHash, 2, game, std::bit_cast<uint32_t>(defaultValue), nullptr };
+    }
+
+    constexpr Field str(uint32_t nameHash, const char* defaultValue, uint8_t game = BcsvSchema::BOTH)
+    {
+        return { nameHash, 6, game, 0, defaultValue };
+    }
+
+    // every placed object's table starts with these
+    constexpr std::array<Field, 8> PLACEMENT_FIELDS = {
+        str("name"_bcsv, ""),
+        i32("l_id"_bcsv, 0),
+        f32("pos_x"_bcsv, 0), f32("pos_y"_bcsv, 0), f32("pos_z"_bcsv, 0),
+        f32("dir_x"_bcsv, 0), f32("dir_y"_bcsv, 0), f32("dir_z"_bcsv, 0)
+    };
+
+    template<size_t N>
+    constexpr std::array<Field, PLACEMENT_FIELDS.size() + N> placed(const std::array<Field, N>& fields)
+    {
+        std::array<Field, PLACEMENT_FIELDS.size() + N> ret = {};
+        for(size_t i = 0; i < PLACEMENT_FIELDS.size(); i++)
+            ret[i] = PLACEMENT_FIELDS[i];
+        for(size_t i = 0; i < N; i++)
+            ret[PLACEMENT_FIELDS.size() + i] = fields[i];
+
+        return ret;
+    }
+
+    constexpr uint32_t NONE = uint32_t(-1);
+    constexpr uint16_t NONE16 = uint16_t(-1);
+
+    constexpr auto STAGE_OBJ_INFO = PLACEMENT_FIELDS;
+
+    constexpr auto OBJ_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        i32("Obj_arg0"_bcsv, NONE), i32("Obj_arg1"_bcsv, NONE), i32("Obj_arg2"_bcsv, NONE), i32("Obj_arg3"_bcsv, NONE),
+        i32("Obj_arg4"_bcsv, NONE), i32("Obj_arg5"_bcsv, NONE), i32("Obj_arg6"_bcsv, NONE), i32("Obj_arg7"_bcsv, NONE),
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_DEAD"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        i32("CameraSetId"_bcsv, NONE), i32("CastId"_bcsv, NONE), i32("ViewGroupId"_bcsv, NONE),
+        i16("ShapeModelNo"_bcsv, NONE16), i16("CommonPath_ID"_bcsv, NONE16), i16("ClippingGroupId"_bcsv, NONE16),
+        i16("GroupId"_bcsv, NONE16), i16("DemoGroupId"_bcsv, NONE16), i16("MapParts_ID"_bcsv, NONE16),
+        i32("MessageId"_bcsv, NONE),
+        i32("SW_SLEEP"_bcsv, NONE, BcsvSchema::SMG1),
+        i32("SW_AWAKE"_bcsv, NONE, BcsvSchema::SMG2), i32("SW_PARAM"_bcsv, NONE, BcsvSchema::SMG2),
+        f32("ParamScale"_bcsv, 1, BcsvSchema::SMG2),
+        i16("Obj_ID"_bcsv, NONE16, BcsvSchema::SMG2), i16("GeneratorID"_bcsv, NONE16, BcsvSchema::SMG2)
+    }));
+
+    constexpr auto MAP_PARTS_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        i32("Obj_arg0"_bcsv, NONE), i32("Obj_arg1"_bcsv, NONE), i32("Obj_arg2"_bcsv, NONE), i32("Obj_arg3"_bcsv, NONE),
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_DEAD"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        i32("CameraSetId"_bcsv, NONE), i32("CastId"_bcsv, NONE), i32("ViewGroupId"_bcsv, NONE),
+        i16("ShapeModelNo"_bcsv, NONE16), i16("CommonPath_ID"_bcsv, NONE16), i16("ClippingGroupId"_bcsv, NONE16),
+        i16("GroupId"_bcsv, NONE16), i16("DemoGroupId"_bcsv, NONE16),
+        i32("MoveConditionType"_bcsv, 0), i32("RotateSpeed"_bcsv, 0), i32("RotateAngle"_bcsv, 0), i32("RotateAxis"_bcsv, 0),
+        i32("RotateAccelType"_bcsv, 0), i32("RotateStopTime"_bcsv, 0), i32("RotateType"_bcsv, 0),
+        i32("ShadowType"_bcsv, 0), i32("SignMotionType"_bcsv, 0), i32("PressType"_bcsv, 0),
+        i32("FarClip"_bcsv, NONE),
+        i32("SW_SLEEP"_bcsv, NONE, BcsvSchema::SMG1),
+        i32("SW_AWAKE"_bcsv, NONE, BcsvSchema::SMG2), i32("SW_PARAM"_bcsv, NONE, BcsvSchema::SMG2),
+        f32("ParamScale"_bcsv, 1, BcsvSchema::SMG2),
+        i16("ParentId"_bcsv, NONE16, BcsvSchema::SMG2), i16("MapParts_ID"_bcsv, NONE16, BcsvSchema::SMG2),
+        i16("Obj_ID"_bcsv, NONE16, BcsvSchema::SMG2)
+    }));
+
+    constexpr auto AREA_OBJ_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        i32("Obj_arg0"_bcsv, NONE), i32("Obj_arg1"_bcsv, NONE), i32("Obj_arg2"_bcsv, NONE), i32("Obj_arg3"_bcsv, NONE),
+        i32("Obj_arg4"_bcsv, NONE), i32("Obj_arg5"_bcsv, NONE), i32("Obj_arg6"_bcsv, NONE), i32("Obj_arg7"_bcsv, NONE),
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        i32("FollowId"_bcsv, NONE),
+        i16("CommonPath_ID"_bcsv, NONE16), i16("ClippingGroupId"_bcsv, NONE16), i16("GroupId"_bcsv, NONE16),
+        i16("DemoGroupId"_bcsv, NONE16), i16("MapParts_ID"_bcsv, NONE16), i16("Obj_ID"_bcsv, NONE16),
+        i32("SW_SLEEP"_bcsv, NONE, BcsvSchema::SMG1), i16("ChildObjId"_bcsv, NONE16, BcsvSchema::SMG1),
+        i32("SW_AWAKE"_bcsv, NONE, BcsvSchema::SMG2), i32("Priority"_bcsv, 0, BcsvSchema::SMG2),
+        i16("AreaShapeNo"_bcsv, 0, BcsvSchema::SMG2)
+    }));
+
+    constexpr auto CAMERA_CUBE_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        i32("Obj_arg0"_bcsv, NONE), i32("Obj_arg1"_bcsv, NONE), i32("Obj_arg2"_bcsv, NONE), i32("Obj_arg3"_bcsv, NONE),
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        // TODO what are these two field names?
+        i32(0x50F5D5E6, NONE), i32(0xCDC4FEAD, NONE),
+        str("Validity"_bcsv, "Valid"),
+        i32("FollowId"_bcsv, NONE),
+        i16("MapParts_ID"_bcsv, NONE16), i16("Obj_ID"_bcsv, NONE16),
+        i32("SW_SLEEP"_bcsv, NONE, BcsvSchema::SMG1), i16("ChildObjId"_bcsv, 0, BcsvSchema::SMG1),
+        i32("SW_AWAKE"_bcsv, NONE, BcsvSchema::SMG2), i32("Priority"_bcsv, 0, BcsvSchema::SMG2),
+        i16("AreaShapeNo"_bcsv, 0, BcsvSchema::SMG2)
+    }));
+
+    constexpr auto PLANET_OBJ_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        f32("Range"_bcsv, -1), f32("Distant"_bcsv, 0),
+        i32("Priority"_bcsv, 0), i32("Inverse"_bcsv, 0),
+        str("Power"_bcsv, "Normal"), str("Gravity_type"_bcsv, "Normal"),
+        i32("Obj_arg0"_bcsv, NONE), i32("Obj_arg1"_bcsv, NONE), i32("Obj_arg2"_bcsv, NONE), i32("Obj_arg3"_bcsv, NONE),
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_DEAD"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        i32("FollowId"_bcsv, NONE),
+        i16("ShapeModelNo"_bcsv, NONE16), i16("CommonPath_ID"_bcsv, NONE16), i16("ClippingGroupId"_bcsv, NONE16),
+        i16("GroupId"_bcsv, NONE16), i16("DemoGroupId"_bcsv, NONE16), i16("MapParts_ID"_bcsv, NONE16),
+        i16("Obj_ID"_bcsv, NONE16),
+        i32("SW_SLEEP"_bcsv, NONE, BcsvSchema::SMG1), i16("ChildObjId"_bcsv, NONE16, BcsvSchema::SMG1),
+        i32("SW_AWAKE"_bcsv, NONE, BcsvSchema::SMG2)
+    }));
+
+    constexpr auto START_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        i32("Obj_arg0"_bcsv, NONE),
+        i32("MarioNo"_bcsv, 0), i32("Camera_id"_bcsv, NONE)
+    }));
+
+    constexpr auto DEMO_OBJ_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        i32("Obj_arg0"_bcsv, NONE), i32("Obj_arg1"_bcsv, NONE), i32("Obj_arg2"_bcsv, NONE), i32("Obj_arg3"_bcsv, NONE),
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_DEAD"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        str("DemoName"_bcsv, "undefined"), str("TimeSheetName"_bcsv, "undefined"),
+        i32("DemoSkip"_bcsv, NONE, BcsvSchema::SMG2)
+    }));
+
+    constexpr auto GENERAL_POS_INFO = placed(std::to_array<Field>({
+        str("PosName"_bcsv, "undefined"),
+        i16("Obj_ID"_bcsv, NONE16),
+        i16("ChildObjId"_bcsv, NONE16, BcsvSchema::SMG1)
+    }));
+
+    constexpr auto DEBUG_MOVE_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        str("PosName"_bcsv, "undefined"),
+        i16("Obj_ID"_bcsv, NONE16),
+        i16("ChildObjId"_bcsv, NONE16, BcsvSchema::SMG1)
+    }));
+
+    constexpr auto SOUND_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        i32("Obj_arg0"_bcsv, NONE), i32("Obj_arg1"_bcsv, NONE), i32("Obj_arg2"_bcsv, NONE), i32("Obj_arg3"_bcsv, NONE),
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_DEAD"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        i16("CommonPath_ID"_bcsv, NONE16)
+    }));
+
+    constexpr auto CHILD_OBJ_INFO = placed(std::to_array<Field>({
+        f32("scale_x"_bcsv, 1), f32("scale_y"_bcsv, 1), f32("scale_z"_bcsv, 1),
+        i32("Obj_arg0"_bcsv, NONE), i32("Obj_arg1"_bcsv, NONE), i32("Obj_arg2"_bcsv, NONE), i32("Obj_arg3"_bcsv, NONE),
+        i32("Obj_arg4"_bcsv, NONE), i32("Obj_arg5"_bcsv, NONE), i32("Obj_arg6"_bcsv, NONE), i32("Obj_arg7"_bcsv, NONE),
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_DEAD"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        i32("SW_SLEEP"_bcsv, NONE),
+        i32("CameraSetId"_bcsv, NONE), i32("CastId"_bcsv, NONE), i32("ViewGroupId"_bcsv, NONE), i32("MessageId"_bcsv, NONE),
+        i16("ParentID"_bcsv, NONE16), i16("ShapeModelNo"_bcsv, NONE16), i16("CommonPath_ID"_bcsv, NONE16),
+        i16("ClippingGroupId"_bcsv, NONE16), i16("GroupId"_bcsv, NONE16), i16("DemoGroupId"_bcsv, NONE16),
+        i16("MapParts_ID"_bcsv, NONE16)
+    }));
+
+    constexpr auto CHANGE_OBJ_INFO = placed(std::to_array<Field>({
+        i32("SW_APPEAR"_bcsv, NONE), i32("SW_DEAD"_bcsv, NONE), i32("SW_A"_bcsv, NONE), i32("SW_B"_bcsv, NONE),
+        // TODO what are these field names?
+        i16(0x55CFC442, NONE16), i16(0xC4F73392, NONE16)
+    }));
+
+    constexpr auto ZONE_LIST = std::to_array<Field>({
+        str("ZoneName"_bcsv, "")
+    });
+
+    const BcsvSchema SCHEMAS[] = {
+        { "StageObjInfo", STAGE_OBJ_INFO },
+        { "ObjInfo", OBJ_INFO },
+        { "MapPartsInfo", MAP_PARTS_INFO },
+        { "AreaObjInfo", AREA_OBJ_INFO },
+        { "CameraCubeInfo", CAMERA_CUBE_INFO },
+        { "PlanetObjInfo", PLANET_OBJ_INFO },
+        { "StartInfo", START_INFO },
+        { "DemoObjInfo", DEMO_OBJ_INFO },
+        { "GeneralPosInfo", GENERAL_POS_INFO },
+        { "DebugMoveInfo", DEBUG_MOVE_INFO },
+        { "SoundInfo", SOUND_INFO },
+        { "ChildObjInfo", CHILD_OBJ_INFO },
+        { "ChangeObjInfo", CHANGE_OBJ_INFO },
+        { "ZoneList", ZONE_LIST }
+    };
+}
+
+const std::array<BcsvFile::RecordField, 9> BcsvSchema::Placement::FIELDS = {{
+    { "pos_x"_bcsv, offsetof(Placement, pos_x), 2 },
+    { "pos_y"_bcsv, offsetof(Placement, pos_y), 2 },
+    { "pos_z"_bcsv, offsetof(Placement, pos_z), 2 },
+    { "dir_x"_bcsv, offsetof(Placement, dir_x), 2 },
+    { "dir_y"_bcsv, offsetof(Placement, dir_y), 2 },
+    { "dir_z"_bcsv, offsetof(Placement, dir_z), 2 },
+    { "scale_x"_bcsv, offsetof(Placement, scale_x), 2 },
+    { "scale_y"_bcsv, offsetof(Placement, scale_y), 2 },
+    { "scale_z"_bcsv, offsetof(Placement, scale_z), 2 }
+}};
+
+const BcsvSchema* BcsvSchema::find(const QString& tableName)
+{
+    for(const BcsvSchema& schema : SCHEMAS)
+    {
+        if(tableName == schema.tableName)
+            return &schema;
+    }
+
+    return nullptr;
+}
+
+BcsvFile::Entry BcsvSchema::newRow(int game) const
+{
+    std::shared_ptr<BcsvFile::Table> table = std::make_shared<BcsvFile::Table>();
+    table->numRows = 1;
+    table->columns.reserve(fields.size());
+
+    for(const Field& field : fields)
+    {
+        if(field.game != BOTH && field.game != game)
+            continue;
+
+        BcsvFile::Column& column = table->columns.emplace_back();
+        column.nameHash = field.nameHash;
+
+        switch(BcsvFile::valueIndex(field.type))
+        {
+            case 0: column.values = std::vector<uint32_t>{ field.defaultBits }; break;
+            case 1: column.values = std::vector<uint16_t>{ uint16_t(field.defaultBits) }; break;
+            case 2: column.values = std::vector<uint8_t>{ uint8_t(field.defaultBits) }; break;
+            case 3: column.values = std::vector<float>{ std::bit_cast<float>(field.defaultBits) }; break;
+            case 4: column.values = std::vector<BcsvFile::StringId>{ table->intern(field.defaultString) }; break;
+        }
+    }
+
+    return BcsvFile::Entry(std::move(table), 0);
+}
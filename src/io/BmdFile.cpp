@@ -6,18 +6,18 @@
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
 
-BmdFile::BmdFile(BaseFile* inRarcFile) : file(inRarcFile)
+BmdFile::BmdFile(BaseFile* inRarcFile)
+        : file(inRarcFile), m_contentsOwner(file->shareContents()), m_reader(file->getContents())
 {
-    file->setBigEndian(true);
 
-    file->position(0xC);
-    uint32_t numSections = file->readInt();
+    m_reader.position(0xC);
+    uint32_t numSections = m_reader.readInt();
 
-    file->skip(0x10);
+    m_reader.skip(0x10);
 
     for(uint32_t i = 0; i < numSections; i++)
     {
-        QString section= file->readString(4, "ASCII"); // TODO redo all these with noclip code
+        QString section= m_reader.readString(4, "ASCII"); // TODO redo all these with noclip code
         if(section == "INF1")
             readINF1();
         if(section == "VTX1")
@@ -39,29 +39,56 @@ BmdFile::BmdFile(BaseFile* inRarcFile) : file(inRarcFile)
     }
 }
 
+uint64_t BmdFile::memorySize() const
+{
+    auto bytes = [](const auto& vec) -> uint64_t { return vec.capacity() * sizeof(vec[0]); };
+
+    uint64_t size = sizeof(BmdFile);
+
+    size += vtx1.vertexArrays.size() * sizeof(GX::VertexArray);
+
+    size += bytes(evp1.envelopes) + bytes(evp1.inverseBinds);
+    for(const Envelope& envelope : evp1.envelopes)
+        size += bytes(envelope.weightedBones);
+
+    size += bytes(drw1.matrixDefinitions);
+    size += bytes(jnt1.joints);
+
+    size += bytes(m_materials);
+    for(const Material& material : m_materials)
+    {
+        size += bytes(material.indices) + bytes(material.texMatrices) + bytes(material.indTexMatrices);
+        size += bytes(material.colorMatRegs) + bytes(material.colorAmbRegs) + bytes(material.colorConstants) + bytes(material.colorRegisters);
+    }
+
+    size += bytes(m_textures) + bytes(m_samplers);
+
+    return size;
+}
+
 void BmdFile::readINF1()
 {
-    uint32_t sectionStart = file->position() - 0x4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 0x4;
+    uint32_t sectionSize = m_reader.readInt();
 
-    J3DLoadFlags loadFlags = J3DLoadFlags(file->readShort());
-    file->skip(2);
-    uint32_t mtxGroupCount = file->readInt();
-    uint32_t vertexCount = file->readInt();
-    uint32_t hierarchyOffset = file->readInt();
-    std::span<uint8_t> hierarchyData = file->slice(sectionStart + hierarchyOffset, sectionStart + sectionSize);
+    J3DLoadFlags loadFlags = J3DLoadFlags(m_reader.readShort());
+    m_reader.skip(2);
+    uint32_t mtxGroupCount = m_reader.readInt();
+    uint32_t vertexCount = m_reader.readInt();
+    uint32_t hierarchyOffset = m_reader.readInt();
+    std::span<const uint8_t> hierarchyData = m_reader.slice(sectionStart + hierarchyOffset, sectionStart + sectionSize);
 
     inf1 = INF1{ hierarchyData, loadFlags };
 
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 void BmdFile::readVTX1()
 {
-    uint32_t sectionStart = file->position() - 0x4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 0x4;
+    uint32_t sectionSize = m_reader.readInt();
 
-    uint32_t formatOffset = file->readInt();
+    uint32_t formatOffset = m_reader.readInt();
     uint32_t dataOffsetLookupTable = 0x0C;
 
     // Data tables are stored in this order. Assumed to be hardcoded in a
@@ -85,14 +112,14 @@ void BmdFile::readVTX1()
     uint32_t offset = formatOffset;
     std::unordered_map<GX::Attr_t, GX::VertexArray> vertexArrays;
     while (true) {
-        file->position(offset);
-        GX::Attr_t vtxAttrib = GX::Attr_t(file->readInt());
+        m_reader.position(offset);
+        GX::Attr_t vtxAttrib = GX::Attr_t(m_reader.readInt());
         if (vtxAttrib == GX::Attr::NUL)
             break;
 
-        GX::CompCnt_t compCnt = GX::CompCnt_t(file->readInt());
-        GX::CompType_t compType = GX::CompType_t(file->readInt());
-        uint8_t compShift = file->readByte();
+        GX::CompCnt_t compCnt = GX::CompCnt_t(m_reader.readInt());
+        GX::CompType_t compType = GX::CompType_t(m_reader.readInt());
+        uint8_t compShift = m_reader.readByte();
         offset += 0x10;
 
         uint32_t formatIdx = indexOf(dataTables, vtxAttrib);
@@ -108,21 +135,21 @@ void BmdFile::readVTX1()
         uint32_t dataOffsetLookupTableEntry = dataOffsetLookupTable + formatIdx*0x04;
         uint32_t dataOffsetLookupTableEnd = dataOffsetLookupTable + dataTables.size()*0x04;
 
-        file->position(dataOffsetLookupTableEntry);
-        uint32_t dataStart = file->readInt();
+        m_reader.position(dataOffsetLookupTableEntry);
+        uint32_t dataStart = m_reader.readInt();
 
         // find dataEnd
         uint32_t dataEnd = sectionSize; // TODO is sectionSize the right default value?
-        file->position(dataOffsetLookupTableEntry + 0x04);
-        while (file->position() < dataOffsetLookupTableEnd) {
-            uint32_t dataOffset = file->readInt();
+        m_reader.position(dataOffsetLookupTableEntry + 0x04);
+        while (m_reader.position() < dataOffsetLookupTableEnd) {
+            uint32_t dataOffset = m_reader.readInt();
             if (dataOffset != 0)
                 dataEnd =  dataOffset;
         }
 
         uint32_t dataOffset = dataStart;
         uint32_t dataSize = dataEnd - dataStart;
-        std::span<uint8_t> vtxDataBuffer = file->slice(dataOffset, dataOffset + dataSize);
+        std::span<const uint8_t> vtxDataBuffer = m_reader.slice(dataOffset, dataOffset + dataSize);
         GX::VertexArray vertexArray = { vtxAttrib, compType, compCnt, compShift, vtxDataBuffer, dataOffset, dataSize };
 
         vertexArrays.insert(std::make_pair(vtxAttrib, vertexArray));
@@ -130,39 +157,52 @@ void BmdFile::readVTX1()
 
     vtx1 = { vertexArrays };
 
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 void BmdFile::readEVP1()
 {
-    uint32_t sectionStart = file->position() - 4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 4;
+    uint32_t sectionSize = m_reader.readInt();
+
+    uint16_t envelopeTableCount = m_reader.readShort();
+    m_reader.skip(0x2);
+
+    uint32_t weightedBoneCountTableOffset = m_reader.readInt();
+    uint32_t weightedBoneIndexTableOffset = m_reader.readInt();
+    uint32_t weightedBoneWeightTableOffset = m_reader.readInt();
+    uint32_t inverseBindPoseTableOffset = m_reader.readInt();
+
+    std::vector<uint8_t> weightedBoneCounts(envelopeTableCount);
+    m_reader.position(sectionStart + weightedBoneCountTableOffset);
+    m_reader.readBytes(weightedBoneCounts);
 
-    uint16_t envelopeTableCount = file->readShort();
-    file->skip(0x2);
+    uint32_t totalWeightedBones = 0;
+    for(uint8_t count : weightedBoneCounts)
+        totalWeightedBones += count;
 
-    uint32_t weightedBoneCountTableOffset = file->readInt();
-    uint32_t weightedBoneIndexTableOffset = file->readInt();
-    uint32_t weightedBoneWeightTableOffset = file->readInt();
-    uint32_t inverseBindPoseTableOffset = file->readInt();
+    // the index and weight tables are flat arrays, so decode them in one go
+    std::vector<uint16_t> weightedBoneIndices(totalWeightedBones);
+    m_reader.position(sectionStart + weightedBoneIndexTableOffset);
+    m_reader.readShorts(weightedBoneIndices);
 
-    uint16_t weightedBoneId = 0;
+    std::vector<float> weightedBoneWeights(totalWeightedBones);
+    m_reader.position(sectionStart + weightedBoneWeightTableOffset);
+    m_reader.readFloats(weightedBoneWeights);
+
+    uint32_t weightedBoneId = 0;
     uint16_t maxBoneIndex = 0; // TODO this was -1 but uint?
     std::vector<Envelope> envelopes;
-    for(int i = 0; i < envelopeTableCount; i++)
+    envelopes.reserve(envelopeTableCount);
+    for(uint8_t numWeightedBones : weightedBoneCounts)
     {
-        file->position(sectionStart + weightedBoneCountTableOffset + i);
-        uint8_t numWeightedBones = file->readByte();
-
         std::vector<WeightedBone> weightedBones;
+        weightedBones.reserve(numWeightedBones);
 
         for(int j = 0; j < numWeightedBones; j++)
         {
-            file->position(sectionStart + weightedBoneCountTableOffset + weightedBoneId * 0x02);
-            uint16_t index = file->readShort();
-
-            file->position(sectionStart + weightedBoneWeightTableOffset + weightedBoneId * 0x04);
-            float weight = file->readFloat();
+            uint16_t index = weightedBoneIndices[weightedBoneId];
+            float weight = weightedBoneWeights[weightedBoneId];
 
             weightedBones.push_back({weight, index});
             maxBoneIndex = std::max(maxBoneIndex, index);
@@ -172,82 +212,72 @@ void BmdFile::readEVP1()
         envelopes.push_back({weightedBones});
     }
 
+    // inverse binds are 3x4 matrices, stored back to back
     std::vector<glm::mat4> inverseBinds;
+    inverseBinds.reserve(maxBoneIndex + 1);
+    m_reader.position(sectionStart + inverseBindPoseTableOffset);
     for(int i = 0; i < maxBoneIndex + 1; i++)
     {
-        file->position(sectionStart + inverseBindPoseTableOffset + (i * 0x30));
-
-        float m00 = file->readFloat();
-        float m10 = file->readFloat();
-        float m20 = file->readFloat();
-        float m30 = file->readFloat();
-        float m01 = file->readFloat();
-        float m11 = file->readFloat();
-        float m21 = file->readFloat();
-        float m31 = file->readFloat();
-        float m02 = file->readFloat();
-        float m12 = file->readFloat();
-        float m22 = file->readFloat();
-        float m32 = file->readFloat();
+        auto m = m_reader.readStruct<std::array<float, 12>>();
 
         inverseBinds.push_back(glm::mat4( // TODO is this ctor accurate?
-            m00, m01, m02, 0,
-            m10, m11, m12, 0,
-            m20, m21, m22, 0,
-            m30, m31, m32, 1
+            m[0], m[4], m[8],  0,
+            m[1], m[5], m[9],  0,
+            m[2], m[6], m[10], 0,
+            m[3], m[7], m[11], 1
         ));
     }
 
     evp1 = { envelopes, inverseBinds };
 
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 void BmdFile::readDRW1()
 {
-    uint32_t sectionStart = file->position() - 4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 4;
+    uint32_t sectionSize = m_reader.readInt();
 
-    uint16_t drawMatrixCount = file->readShort();
-    file->skip(0x2);
+    uint16_t drawMatrixCount = m_reader.readShort();
+    m_reader.skip(0x2);
 
-    uint32_t drawMatrixTypeTableOffset = file->readInt();
-    uint32_t dataArrayOffset = file->readInt();
+    uint32_t drawMatrixTypeTableOffset = m_reader.readInt();
+    uint32_t dataArrayOffset = m_reader.readInt();
 
     std::vector<DRW1Matrix> matrixDefinitions;
     for(int i = 0; i < drawMatrixCount; i++)
     {
-        file->position(sectionStart + drawMatrixTypeTableOffset + i);
-        DRW1MatrixKind kind = DRW1MatrixKind(file->readByte());
+        m_reader.position(sectionStart + drawMatrixTypeTableOffset + i);
+        DRW1MatrixKind kind = DRW1MatrixKind(m_reader.readByte());
 
-        file->position(sectionStart + dataArrayOffset + i * 0x02);
-        uint16_t param = file->readShort();
+        m_reader.position(sectionStart + dataArrayOffset + i * 0x02);
+        uint16_t param = m_reader.readShort();
 
         matrixDefinitions.push_back({kind, param});
     }
 
     drw1 = { matrixDefinitions };
 
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 void BmdFile::readJNT1()
 {
-    uint32_t sectionStart = file->position() - 4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 4;
+    uint32_t sectionSize = m_reader.readInt();
 
-    uint16_t jointDataCount = file->readShort();
-    assert(file->readShort() == 0xFFFF);
+    uint16_t jointDataCount = m_reader.readShort();
+    assert(m_reader.readShort() == 0xFFFF);
 
-    uint32_t jointDataTableOffset = file->readInt();
-    uint32_t remapTableOffset = file->readInt();
-    uint32_t nameTableOffset = file->readInt();
+    uint32_t jointDataTableOffset = m_reader.readInt();
+    uint32_t remapTableOffset = m_reader.readInt();
+    uint32_t nameTableOffset = m_reader.readInt();
 
     std::vector<uint16_t> remapTable;
     for(int i = 0; i < jointDataCount; i++)
     {
-        file->position(sectionStart + remapTableOffset + (i * 0x02));
-        remapTable.push_back(file->readShort());
+        m_reader.position(sectionStart + remapTableOffset + (i * 0x02));
+        remapTable.push_back(m_reader.readShort());
     }
 
     std::vector<QString> nameTable = readStringTable(sectionStart + nameTableOffset);
@@ -258,40 +288,29 @@ void BmdFile::readJNT1()
         QString& name = nameTable[i];
         uint32_t jointDataTableIndex = jointDataTableOffset + (remapTable[i] * 0x40);
 
-        file->position(sectionStart + jointDataTableIndex);
+        m_reader.position(sectionStart + jointDataTableIndex);
 
-        uint16_t flags = file->readShort() & 0x00FF;
+        uint16_t flags = m_reader.readShort() & 0x00FF;
         // Maya / SoftImage special flags
-        uint8_t calcFlags = file->readByte();
-
-        file->skip(0x01);
+        uint8_t calcFlags = m_reader.readByte();
 
-        float scaleX = file->readFloat();
-        float scaleY = file->readFloat();
-        float scaleZ = file->readFloat();
+        m_reader.skip(0x01);
 
-        int16_t rotationX = file->readShortS() / 0x7FFF * M_PI;
-        int16_t rotationY = file->readShortS() / 0x7FFF * M_PI;
-        int16_t rotationZ = file->readShortS() / 0x7FFF * M_PI;
+        glm::vec3 scale = readVec3();
 
-        file->skip(0x02);
+        int16_t rotationX = m_reader.readShortS() / 0x7FFF * M_PI;
+        int16_t rotationY = m_reader.readShortS() / 0x7FFF * M_PI;
+        int16_t rotationZ = m_reader.readShortS() / 0x7FFF * M_PI;
 
-        float translationX = file->readFloat();
-        float translationY = file->readFloat();
-        float translationZ = file->readFloat();
+        m_reader.skip(0x02);
 
-        float boundingSphereRadius = file->readFloat();
+        glm::vec3 translation = readVec3();
 
-        float bboxMinX = file->readFloat();
-        float bboxMinY = file->readFloat();
-        float bboxMinZ = file->readFloat();
-        float bboxMaxX = file->readFloat();
-        float bboxMaxY = file->readFloat();
-        float bboxMaxZ = file->readFloat();
+        float boundingSphereRadius = m_reader.readFloat();
 
-        AABB bbox{{bboxMinX, bboxMinY, bboxMinZ}, {bboxMaxX, bboxMaxY, bboxMaxZ}};
+        AABB bbox = m_reader.readStruct<AABB>();
 
-        JointTransformInfo transform{{scaleX, scaleY, scaleZ}, {translationX, translationY, translationZ}};
+        JointTransformInfo transform{scale, translation};
         transform.rotation = glm::quat(glm::orientate3(glm::vec3(rotationX, rotationY, rotationZ))); // TODO is this accurate?
 
         joints.push_back({ name, transform, boundingSphereRadius, bbox, calcFlags });
@@ -299,70 +318,70 @@ void BmdFile::readJNT1()
 
     jnt1 = JNT1{ joints };
 
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 void BmdFile::readSHP1()
 {
-    uint32_t sectionStart = file->position() - 4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 4;
+    uint32_t sectionSize = m_reader.readInt();
 
 
 
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 // huge thanks to noclip.website for this parser!
 void BmdFile::readMAT3()
 {
-    uint32_t sectionStart = file->position() - 4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 4;
+    uint32_t sectionSize = m_reader.readInt();
 
-    uint16_t materialCount = file->readShort();
+    uint16_t materialCount = m_reader.readShort();
 
-    file->skip(0x2);
-    uint32_t materialEntryTableOffsets = file->readInt();
-    uint32_t remapTableOffset = file->readInt();
+    m_reader.skip(0x2);
+    uint32_t materialEntryTableOffsets = m_reader.readInt();
+    uint32_t remapTableOffset = m_reader.readInt();
 
     std::vector<uint16_t> remapTable;
     for(uint32_t i = 0; i < materialCount; i++)
     {
-        file->position(sectionStart + remapTableOffset + i * 0x02);
-        remapTable.push_back(file->readShort());
+        m_reader.position(sectionStart + remapTableOffset + i * 0x02);
+        remapTable.push_back(m_reader.readShort());
     }
 
-    file->position(sectionStart + 0x14);
+    m_reader.position(sectionStart + 0x14);
 
-    uint32_t nameTableOffset = file->readInt();
+    uint32_t nameTableOffset = m_reader.readInt();
     std::vector<QString> nameTable = readStringTable(sectionStart + nameTableOffset);
 
 
-    file->position(sectionStart + 0x18);
-    uint32_t indirectTableOffset = file->readInt();         // 0x18
-    uint32_t cullModeTableOffset = file->readInt();         // 0x1C
-    uint32_t materialColorTableOffset = file->readInt();    // 0x20
-    uint32_t colorChanCountTableOffset = file->readInt();   // 0x24
-    uint32_t colorChanTableOffset = file->readInt();        // 0x28
-    uint32_t ambientColorTableOffset = file->readInt();     // 0x2C
-
-    file->skip(0x08);
-    uint32_t texGenTableOffset = file->readInt();           // 0x38
-    uint32_t postTexGenTableOffset = file->readInt();       // 0x3C
-    uint32_t texMtxTableOffset = file->readInt();           // 0x40
-    uint32_t postTexMtxTableOffset = file->readInt();       // 0x44
-    uint32_t textureTableOffset = file->readInt();          // 0x48
-    uint32_t tevOrderTableOffset = file->readInt();         // 0x4C
-    uint32_t colorRegisterTableOffset = file->readInt();    // 0x50
-    uint32_t colorConstantTableOffset = file->readInt();    // 0x54
-
-    file->skip(0x04);
-    uint32_t tevStageTableOffset = file->readInt();         // 0x58
-    uint32_t tevSwapModeInfoOffset = file->readInt();
-    uint32_t tevSwapModeTableInfoOffset = file->readInt();
-    uint32_t fogInfoTableOffset = file->readInt();
-    uint32_t alphaTestTableOffset = file->readInt();
-    uint32_t blendModeTableOffset = file->readInt();
-    uint32_t zModeTableOffset = file->readInt();
+    m_reader.position(sectionStart + 0x18);
+    uint32_t indirectTableOffset = m_reader.readInt();         // 0x18
+    uint32_t cullModeTableOffset = m_reader.readInt();         // 0x1C
+    uint32_t materialColorTableOffset = m_reader.readInt();    // 0x20
+    uint32_t colorChanCountTableOffset = m_reader.readInt();   // 0x24
+    uint32_t colorChanTableOffset = m_reader.readInt();        // 0x28
+    uint32_t ambientColorTableOffset = m_reader.readInt();     // 0x2C
+
+    m_reader.skip(0x08);
+    uint32_t texGenTableOffset = m_reader.readInt();           // 0x38
+    uint32_t postTexGenTableOffset = m_reader.readInt();       // 0x3C
+    uint32_t texMtxTableOffset = m_reader.readInt();           // 0x40
+    uint32_t postTexMtxTableOffset = m_reader.readInt();       // 0x44
+    uint32_t textureTableOffset = m_reader.readInt();          // 0x48
+    uint32_t tevOrderTableOffset = m_reader.readInt();         // 0x4C
+    uint32_t colorRegisterTableOffset = m_reader.readInt();    // 0x50
+    uint32_t colorConstantTableOffset = m_reader.readInt();    // 0x54
+
+    m_reader.skip(0x04);
+    uint32_t tevStageTableOffset = m_reader.readInt();         // 0x58
+    uint32_t tevSwapModeInfoOffset = m_reader.readInt();
+    uint32_t tevSwapModeTableInfoOffset = m_reader.readInt();
+    uint32_t fogInfoTableOffset = m_reader.readInt();
+    uint32_t alphaTestTableOffset = m_reader.readInt();
+    uint32_t blendModeTableOffset = m_reader.readInt();
+    uint32_t zModeTableOffset = m_reader.readInt();
 
     m_materials.clear();
 
@@ -372,8 +391,8 @@ void BmdFile::readMAT3()
         QString& name = nameTable[i];
         uint32_t materialEntryIndex = materialEntryTableOffsets + (0x014C * remapTable[i]);
 
-        file->position(sectionStart + materialEntryIndex);
-        uint8_t materialMode = file->readByte();
+        m_reader.position(sectionStart + materialEntryIndex);
+        uint8_t materialMode = m_reader.readByte();
 
         // Bitfield:
         //   0n001: OPA (Opaque)
@@ -382,21 +401,21 @@ void BmdFile::readMAT3()
         // EDG has never been seen, so ignore it
         assert(materialMode == 0b001 || materialMode == 0b100);
 
-        uint8_t cullModeIndex = file->readByte();
-        uint8_t colorChanNumIndex = file->readByte();
-        file->skip(0x3);
-        uint8_t zModeIndex = file->readByte();
+        uint8_t cullModeIndex = m_reader.readByte();
+        uint8_t colorChanNumIndex = m_reader.readByte();
+        m_reader.skip(0x3);
+        uint8_t zModeIndex = m_reader.readByte();
 
         std::vector<QColor> colorMatRegs;
         for(uint32_t j = 0; j < 2; j++)
         {
 
-            file->position(sectionStart + materialEntryIndex + 0x08 + j * 0x02);
-            uint16_t matColorIndex = file->readShort();
+            m_reader.position(sectionStart + materialEntryIndex + 0x08 + j * 0x02);
+            uint16_t matColorIndex = m_reader.readShort();
 
             if (matColorIndex != 0xFFFF)
             {
-                file->position(sectionStart + materialColorTableOffset + matColorIndex * 0x04);
+                m_reader.position(sectionStart + materialColorTableOffset + matColorIndex * 0x04);
                 colorMatRegs.push_back(readColor_RGBA8());
             }
             else
@@ -409,12 +428,12 @@ void BmdFile::readMAT3()
         for(uint32_t j = 0; j < 2; j++)
         {
 
-            file->position(sectionStart + materialEntryIndex + 0x14 + j * 0x02);
-            uint16_t ambColorIndex = file->readShort();
+            m_reader.position(sectionStart + materialEntryIndex + 0x14 + j * 0x02);
+            uint16_t ambColorIndex = m_reader.readShort();
 
             if (ambColorIndex != 0xFFFF)
             {
-                file->position(sectionStart + ambientColorTableOffset + ambColorIndex * 0x04);
+                m_reader.position(sectionStart + ambientColorTableOffset + ambColorIndex * 0x04);
                 colorAmbRegs.push_back(readColor_RGBA8());
             }
             else
@@ -423,17 +442,17 @@ void BmdFile::readMAT3()
             }
         }
 
-        file->position(sectionStart + colorChanCountTableOffset + colorChanNumIndex);
-        uint8_t lightChannelCount = file->readByte();
+        m_reader.position(sectionStart + colorChanCountTableOffset + colorChanNumIndex);
+        uint8_t lightChannelCount = m_reader.readByte();
         std::vector<GX::LightChannelControl> lightChannels;
         for(uint32_t j = 0; j < lightChannelCount; j++)
         {
-            file->position(sectionStart + materialEntryIndex + 0x0C + (j * 2) * 0x02);
+            m_reader.position(sectionStart + materialEntryIndex + 0x0C + (j * 2) * 0x02);
 
-            GX::ColorChannelControl colorChannel = readColorChannel(sectionStart + colorChanTableOffset, file->readShort());
+            GX::ColorChannelControl colorChannel = readColorChannel(sectionStart + colorChanTableOffset, m_reader.readShort());
 
-            file->position(sectionStart + materialEntryIndex + 0x0C + (j * 2 + 1) * 0x02);
-            GX::ColorChannelControl alphaChannel = readColorChannel(sectionStart + colorChanTableOffset, file->readShort());
+            m_reader.position(sectionStart + materialEntryIndex + 0x0C + (j * 2 + 1) * 0x02);
+            GX::ColorChannelControl alphaChannel = readColorChannel(sectionStart + colorChanTableOffset, m_reader.readShort());
 
             lightChannels.push_back({ colorChannel, alphaChannel });
         }
@@ -441,27 +460,27 @@ void BmdFile::readMAT3()
         std::vector<GX::TexGen> texGens;
         for(uint32_t j = 0; j < 8; j++)
         {
-            file->position(sectionStart + materialEntryIndex + 0x28 + j * 0x02);
-            int16_t texGenIndex = file->readShortS();
+            m_reader.position(sectionStart + materialEntryIndex + 0x28 + j * 0x02);
+            int16_t texGenIndex = m_reader.readShortS();
 
             if(texGenIndex < 0)
                 continue; // negative index means skip
 
-            file->position(sectionStart + texGenTableOffset + texGenIndex * 0x04);
-            GX::TexGenType_t type = GX::TexGenType_t(file->readByte());
-            GX::TexGenSrc_t source = GX::TexGenSrc_t(file->readByte());
-            GX::TexGenMatrix_t matrixCheck = GX::TexGenMatrix_t(file->readByte());
-            assert(file->readByte() == 0xFF);
+            m_reader.position(sectionStart + texGenTableOffset + texGenIndex * 0x04);
+            GX::TexGenType_t type = GX::TexGenType_t(m_reader.readByte());
+            GX::TexGenSrc_t source = GX::TexGenSrc_t(m_reader.readByte());
+            GX::TexGenMatrix_t matrixCheck = GX::TexGenMatrix_t(m_reader.readByte());
+            assert(m_reader.readByte() == 0xFF);
 
             GX::PostTexGenMatrix_t postMatrix = GX::PostTexGenMatrix::PTIDENTITY;
 
-            file->position(sectionStart + materialEntryIndex + 0x38 + j * 0x02);
-            int16_t postTexGenIndex = file->readShortS(); // type punning. bad?
+            m_reader.position(sectionStart + materialEntryIndex + 0x38 + j * 0x02);
+            int16_t postTexGenIndex = m_reader.readShortS(); // type punning. bad?
             if(postTexGenTableOffset > 0 && postTexGenIndex >= 0)
             {
-                file->position(sectionStart + postTexGenTableOffset + texGenIndex * 0x04 + 0x02);
-                postMatrix = GX::PostTexGenMatrix_t(file->readByte());
-                assert(file->readByte() == 0xFF);
+                m_reader.position(sectionStart + postTexGenTableOffset + texGenIndex * 0x04 + 0x02);
+                postMatrix = GX::PostTexGenMatrix_t(m_reader.readByte());
+                assert(m_reader.readByte() == 0xFF);
             }
 
             // BTK can apply texture animations to materials that have the matrix set to IDENTITY.
@@ -480,16 +499,16 @@ void BmdFile::readMAT3()
         std::vector<TexMatrix> texMatrices;
         for(uint32_t j = 0; j < 10; j++)
         {
-            file->position(sectionStart + materialEntryIndex + 0x48 + j * 0x02);
-            int16_t texMatrixIndex = file->readShortS();
+            m_reader.position(sectionStart + materialEntryIndex + 0x48 + j * 0x02);
+            int16_t texMatrixIndex = m_reader.readShortS();
 
             if(texMtxTableOffset > 0 && texMatrixIndex >= 0)
             {
                 uint32_t texMtxOffset = texMtxTableOffset + texMatrixIndex * 0x64;
-                file->position(sectionStart + texMtxOffset);
+                m_reader.position(sectionStart + texMtxOffset);
 
-                TexMatrixProjection projection = TexMatrixProjection(file->readByte());
-                uint8_t info = file->readByte();
+                TexMatrixProjection projection = TexMatrixProjection(m_reader.readByte());
+                uint8_t info = m_reader.readByte();
 
                 GX::TexMtxMapMode_t matrixMode = GX::TexMtxMapMode_t(info & 0x3F);
 
@@ -497,27 +516,27 @@ void BmdFile::readMAT3()
                 assert(matrixMode != GX::TexMtxMapMode::ProjmapBasic && matrixMode != GX::TexMtxMapMode::ViewProjmapBasic &&
                         int(matrixMode) != 0x04 && int(matrixMode) != 0x05);
 
-                assert(file->readShort() == 0xFFFF);
+                assert(m_reader.readShort() == 0xFFFF);
 
-                float centerS = file->readFloat();
-                float centerT = file->readFloat();
-                float centerQ = file->readFloat();
+                float centerS = m_reader.readFloat();
+                float centerT = m_reader.readFloat();
+                float centerQ = m_reader.readFloat();
 
-                float scaleS = file->readFloat();
-                float scaleT = file->readFloat();
+                float scaleS = m_reader.readFloat();
+                float scaleT = m_reader.readFloat();
 
-                float rotation = file->readShort() / 0x7FFF;
-                assert(file->readShort() == 0xFFFF);
+                float rotation = m_reader.readShort() / 0x7FFF;
+                assert(m_reader.readShort() == 0xFFFF);
 
-                float translationS = file->readFloat();
-                float translationT = file->readFloat();
+                float translationS = m_reader.readFloat();
+                float translationT = m_reader.readFloat();
 
                 // TODO is this the right order?
                 glm::mat4 effectMatrix(
-                    file->readFloat(), file->readFloat(), file->readFloat(), file->readFloat(),
-                    file->readFloat(), file->readFloat(), file->readFloat(), file->readFloat(),
-                    file->readFloat(), file->readFloat(), file->readFloat(), file->readFloat(),
-                    file->readFloat(), file->readFloat(), file->readFloat(), file->readFloat()
+                    m_reader.readFloat(), m_reader.readFloat(), m_reader.readFloat(), m_reader.readFloat(),
+                    m_reader.readFloat(), m_reader.readFloat(), m_reader.readFloat(), m_reader.readFloat(),
+                    m_reader.readFloat(), m_reader.readFloat(), m_reader.readFloat(), m_reader.readFloat(),
+                    m_reader.readFloat(), m_reader.readFloat(), m_reader.readFloat(), m_reader.readFloat()
 
                 );
 
@@ -579,12 +598,12 @@ void BmdFile::readMAT3()
         std::vector<int16_t> textureIndexes; // shouldn't this be indices?
         for(uint32_t j = 0; j < 8; j++)
         {
-            file->position(sectionStart + materialEntryIndex + 0x84 + j * 0x02);
-            uint16_t textureTableIndex = file->readShort();
+            m_reader.position(sectionStart + materialEntryIndex + 0x84 + j * 0x02);
+            uint16_t textureTableIndex = m_reader.readShort();
             if(textureTableIndex != 0xFFFF)
             {
-                file->position(sectionStart + textureTableOffset + textureTableIndex * 0x02);
-                textureIndexes.push_back(file->readShort());
+                m_reader.position(sectionStart + textureTableOffset + textureTableIndex * 0x02);
+                textureIndexes.push_back(m_reader.readShort());
             }
             else
             {
@@ -595,11 +614,11 @@ void BmdFile::readMAT3()
         std::vector<QColor> colorConstants; // shouldn't this be indices?
         for(uint32_t j = 0; j < 4; j++)
         {
-            file->position(sectionStart + materialEntryIndex + 0x94 + j * 0x02);
-            uint16_t colorIndex = file->readShort();
+            m_reader.position(sectionStart + materialEntryIndex + 0x94 + j * 0x02);
+            uint16_t colorIndex = m_reader.readShort();
             if(colorIndex != 0xFFFF)
             {
-                file->position(sectionStart + colorConstantTableOffset + colorIndex * 0x04);
+                m_reader.position(sectionStart + colorConstantTableOffset + colorIndex * 0x04);
                 colorConstants.push_back(readColor_RGBA8());
             }
             else
@@ -611,11 +630,11 @@ void BmdFile::readMAT3()
         std::vector<QColor> colorRegisters; // shouldn't this be indices?
         for(uint32_t j = 0; j < 4; j++)
         {
-            file->position(sectionStart + materialEntryIndex + 0xDC + j * 0x02);
-            uint16_t colorIndex = file->readShort();
+            m_reader.position(sectionStart + materialEntryIndex + 0xDC + j * 0x02);
+            uint16_t colorIndex = m_reader.readShort();
             if(colorIndex != 0xFFFF)
             {
-                file->position(sectionStart + colorRegisterTableOffset + colorIndex * 0x08);
+                m_reader.position(sectionStart + colorRegisterTableOffset + colorIndex * 0x08);
                 colorConstants.push_back(readColor_RGBA16());
             }
             else
@@ -632,42 +651,42 @@ void BmdFile::readMAT3()
 
         if(hasIndirectTable)
         {
-            file->position(sectionStart + indirectEntryOffset);
+            m_reader.position(sectionStart + indirectEntryOffset);
 
-            uint8_t hasIndirect = file->readByte();
+            uint8_t hasIndirect = m_reader.readByte();
             assert((hasIndirect & 0b11111110) == 0); // make sure it's a bool
 
-            uint8_t indTexStageNum = file->readByte();
+            uint8_t indTexStageNum = m_reader.readByte();
             assert(indTexStageNum <= 4);
 
             for(uint32_t j = 0; j < indTexStageNum; j++)
             {
                 // SetIndTexOrder
                 uint32_t indTexOrderOffset = indirectEntryOffset + 0x04 + j * 0x04;
-                file->position(sectionStart + indTexOrderOffset);
+                m_reader.position(sectionStart + indTexOrderOffset);
 
-                GX::TexCoordID_t texCoordId = GX::TexCoordID_t(file->readByte());
-                GX::TexMapID_t texture = GX::TexMapID_t(file->readByte());
+                GX::TexCoordID_t texCoordId = GX::TexCoordID_t(m_reader.readByte());
+                GX::TexMapID_t texture = GX::TexMapID_t(m_reader.readByte());
 
                 // SetIndTexCoordScale
                 uint32_t indTexScaleOffset = indirectEntryOffset + 0x04 + (0x04 * 4) + (0x1C * 3) + j * 0x04;
-                file->position(sectionStart + indTexScaleOffset);
+                m_reader.position(sectionStart + indTexScaleOffset);
 
-                GX::IndTexScale_t scaleS = GX::IndTexScale_t(file->readByte());
-                GX::IndTexScale_t scaleT = GX::IndTexScale_t(file->readByte());
+                GX::IndTexScale_t scaleS = GX::IndTexScale_t(m_reader.readByte());
+                GX::IndTexScale_t scaleT = GX::IndTexScale_t(m_reader.readByte());
                 indTexStages.push_back({ texCoordId, texture, scaleS, scaleT });
 
                 // SetIndTexMatrix
                 uint32_t indTexMatrixOffset = indirectEntryOffset + 0x04 + (0x04 * 4) + j * 0x1C;
-                file->position(sectionStart + indTexMatrixOffset);
+                m_reader.position(sectionStart + indTexMatrixOffset);
 
-                float p00 = file->readFloat();
-                float p01 = file->readFloat();
-                float p02 = file->readFloat();
-                float p10 = file->readFloat();
-                float p11 = file->readFloat();
-                float p12 = file->readFloat();
-                float scale = pow(2, file->readInt());
+                float p00 = m_reader.readFloat();
+                float p01 = m_reader.readFloat();
+                float p02 = m_reader.readFloat();
+                float p10 = m_reader.readFloat();
+                float p11 = m_reader.readFloat();
+                float p12 = m_reader.readFloat();
+                float scale = pow(2, m_reader.readInt());
 
                 // TODO should this be a mat2x4?
                 indTexMatrices.push_back(p00*scale);
@@ -686,48 +705,48 @@ void BmdFile::readMAT3()
         for(uint32_t j = 0; j < 16; j++)
         {
             // TevStage
-            file->position(sectionStart + materialEntryIndex + 0xE4 + j * 0x02);
+            m_reader.position(sectionStart + materialEntryIndex + 0xE4 + j * 0x02);
 
-            int16_t tevStageIndex = file->readShortS();
+            int16_t tevStageIndex = m_reader.readShortS();
             if(tevStageIndex < 0)
                 continue;
 
             uint32_t tevStageOffset = tevStageTableOffset + tevStageIndex * 0x14;
-            file->position(sectionStart + tevStageOffset + 1); // skip unk byte
-
-            GX::CC_t colorInA = GX::CC_t(file->readByte());
-            GX::CC_t colorInB = GX::CC_t(file->readByte());
-            GX::CC_t colorInC = GX::CC_t(file->readByte());
-            GX::CC_t colorInD = GX::CC_t(file->readByte());
-            GX::TevOp_t colorOp = GX::TevOp_t(file->readByte());
-            GX::TevBias_t colorBias = GX::TevBias_t(file->readByte());
-            GX::TevScale_t colorScale = GX::TevScale_t(file->readByte());
-            bool colorClamp = file->readByte();
-            GX::Register_t colorRegID = GX::Register_t(file->readByte());
-
-            GX::CA_t alphaInA = GX::CA_t(file->readByte());
-            GX::CA_t alphaInB = GX::CA_t(file->readByte());
-            GX::CA_t alphaInC = GX::CA_t(file->readByte());
-            GX::CA_t alphaInD = GX::CA_t(file->readByte());
-            GX::TevOp_t alphaOp = GX::TevOp_t(file->readByte());
-            GX::TevBias_t alphaBias = GX::TevBias_t(file->readByte());
-            GX::TevScale_t alphaScale = GX::TevScale_t(file->readByte());
-            bool alphaClamp = file->readByte();
-            GX::Register_t alphaRegID = GX::Register_t(file->readByte());
+            m_reader.position(sectionStart + tevStageOffset + 1); // skip unk byte
+
+            GX::CC_t colorInA = GX::CC_t(m_reader.readByte());
+            GX::CC_t colorInB = GX::CC_t(m_reader.readByte());
+            GX::CC_t colorInC = GX::CC_t(m_reader.readByte());
+            GX::CC_t colorInD = GX::CC_t(m_reader.readByte());
+            GX::TevOp_t colorOp = GX::TevOp_t(m_reader.readByte());
+            GX::TevBias_t colorBias = GX::TevBias_t(m_reader.readByte());
+            GX::TevScale_t colorScale = GX::TevScale_t(m_reader.readByte());
+            bool colorClamp = m_reader.readByte();
+            GX::Register_t colorRegID = GX::Register_t(m_reader.readByte());
+
+            GX::CA_t alphaInA = GX::CA_t(m_reader.readByte());
+            GX::CA_t alphaInB = GX::CA_t(m_reader.readByte());
+            GX::CA_t alphaInC = GX::CA_t(m_reader.readByte());
+            GX::CA_t alphaInD = GX::CA_t(m_reader.readByte());
+            GX::TevOp_t alphaOp = GX::TevOp_t(m_reader.readByte());
+            GX::TevBias_t alphaBias = GX::TevBias_t(m_reader.readByte());
+            GX::TevScale_t alphaScale = GX::TevScale_t(m_reader.readByte());
+            bool alphaClamp = m_reader.readByte();
+            GX::Register_t alphaRegID = GX::Register_t(m_reader.readByte());
 
             // TevOrder
-            file->position(sectionStart + materialEntryIndex + 0xBC + j * 0x02);
+            m_reader.position(sectionStart + materialEntryIndex + 0xBC + j * 0x02);
 
-            uint16_t tevOrderIndex = file->readShort();
+            uint16_t tevOrderIndex = m_reader.readShort();
 
             uint32_t tevOrderOffset = tevOrderTableOffset + tevOrderIndex * 0x04;
-            file->position(sectionStart + tevOrderOffset);
+            m_reader.position(sectionStart + tevOrderOffset);
 
-            GX::TexCoordID_t texCoordID = GX::TexCoordID_t(file->readByte());
-            GX::TexMapID_t texMap = GX::TexMapID_t(file->readByte());
+            GX::TexCoordID_t texCoordID = GX::TexCoordID_t(m_reader.readByte());
+            GX::TexMapID_t texMap = GX::TexMapID_t(m_reader.readByte());
 
             GX::RasColorChannelID_t channelID;
-            switch (GX::ColorChannelID_t(file->readByte())) {
+            switch (GX::ColorChannelID_t(m_reader.readByte())) {
                 case GX::ColorChannelID::COLOR0:
                 case GX::ColorChannelID::ALPHA0:
                 case GX::ColorChannelID::COLOR0A0:
@@ -751,39 +770,39 @@ void BmdFile::readMAT3()
                 default:
                     assert(false);
             }
-            assert(file->readByte() == 0xFF);
+            assert(m_reader.readByte() == 0xFF);
 
             // KonstSel
-            file->position(sectionStart + materialEntryIndex + 0x9C + j);
-            GX::KonstColorSel_t konstColorSel = GX::KonstColorSel_t(file->readByte());
-            file->skip(0x10);
-            GX::KonstAlphaSel_t konstAlphaSel = GX::KonstAlphaSel_t(file->readByte());
+            m_reader.position(sectionStart + materialEntryIndex + 0x9C + j);
+            GX::KonstColorSel_t konstColorSel = GX::KonstColorSel_t(m_reader.readByte());
+            m_reader.skip(0x10);
+            GX::KonstAlphaSel_t konstAlphaSel = GX::KonstAlphaSel_t(m_reader.readByte());
 
             // SetTevSwapMode
-            file->position(sectionStart + materialEntryIndex + 0x104 + j * 0x02);
-            uint16_t tevSwapModeIndex = file->readShort();
+            m_reader.position(sectionStart + materialEntryIndex + 0x104 + j * 0x02);
+            uint16_t tevSwapModeIndex = m_reader.readShort();
 
-            file->position(sectionStart + tevSwapModeInfoOffset + tevSwapModeIndex * 0x04);
-            uint8_t tevSwapModeRasSel = file->readByte();
-            uint8_t tevSwapModeTexSel = file->readByte();
+            m_reader.position(sectionStart + tevSwapModeInfoOffset + tevSwapModeIndex * 0x04);
+            uint8_t tevSwapModeRasSel = m_reader.readByte();
+            uint8_t tevSwapModeTexSel = m_reader.readByte();
 
-            file->position(sectionStart + materialEntryIndex + 0x124 + tevSwapModeRasSel * 0x02);
-            uint16_t tevSwapModeTableRasIndex = file->readShort();
+            m_reader.position(sectionStart + materialEntryIndex + 0x124 + tevSwapModeRasSel * 0x02);
+            uint16_t tevSwapModeTableRasIndex = m_reader.readShort();
 
-            file->position(sectionStart + materialEntryIndex + 0x124 + tevSwapModeTexSel * 0x02);
-            uint16_t tevSwapModeTableTexIndex = file->readShort();
+            m_reader.position(sectionStart + materialEntryIndex + 0x124 + tevSwapModeTexSel * 0x02);
+            uint16_t tevSwapModeTableTexIndex = m_reader.readShort();
 
-            file->position(sectionStart + tevSwapModeTableInfoOffset + tevSwapModeTableRasIndex * 0x04);
-            uint8_t rasSwapA = file->readByte();
-            uint8_t rasSwapB = file->readByte();
-            uint8_t rasSwapC = file->readByte();
-            uint8_t rasSwapD = file->readByte();
+            m_reader.position(sectionStart + tevSwapModeTableInfoOffset + tevSwapModeTableRasIndex * 0x04);
+            uint8_t rasSwapA = m_reader.readByte();
+            uint8_t rasSwapB = m_reader.readByte();
+            uint8_t rasSwapC = m_reader.readByte();
+            uint8_t rasSwapD = m_reader.readByte();
 
-            file->position(sectionStart + tevSwapModeTableInfoOffset + tevSwapModeTableTexIndex * 0x04);
-            uint8_t texSwapA = file->readByte();
-            uint8_t texSwapB = file->readByte();
-            uint8_t texSwapC = file->readByte();
-            uint8_t texSwapD = file->readByte();
+            m_reader.position(sectionStart + tevSwapModeTableInfoOffset + tevSwapModeTableTexIndex * 0x04);
+            uint8_t texSwapA = m_reader.readByte();
+            uint8_t texSwapB = m_reader.readByte();
+            uint8_t texSwapC = m_reader.readByte();
+            uint8_t texSwapD = m_reader.readByte();
 
             GX::SwapTable rasSwapTable = {
                 GX::TevColorChan_t(rasSwapA),
@@ -813,19 +832,19 @@ void BmdFile::readMAT3()
 
             if(hasIndirectTable)
             {
-                file->position(sectionStart + indTexStageOffset);
+                m_reader.position(sectionStart + indTexStageOffset);
 
-                indTexStage = GX::IndTexStageID_t(file->readByte());
-                indTexFormat = GX::IndTexFormat_t(file->readByte());
-                indTexBiasSel = GX::IndTexBiasSel_t(file->readByte());
-                indTexMatrix = GX::IndTexMtxID_t(file->readByte());
+                indTexStage = GX::IndTexStageID_t(m_reader.readByte());
+                indTexFormat = GX::IndTexFormat_t(m_reader.readByte());
+                indTexBiasSel = GX::IndTexBiasSel_t(m_reader.readByte());
+                indTexMatrix = GX::IndTexMtxID_t(m_reader.readByte());
                 assert(indTexMatrix <= GX::IndTexMtxID::T2);
 
-                indTexWrapS = GX::IndTexWrap_t(file->readByte());
-                indTexWrapT = GX::IndTexWrap_t(file->readByte());
-                indTexAddPrev = file->readByte();
-                indTexUseOrigLOD = file->readByte();
-                indTexAlphaSel = GX::IndTexAlphaSel_t(file->readByte());
+                indTexWrapS = GX::IndTexWrap_t(m_reader.readByte());
+                indTexWrapT = GX::IndTexWrap_t(m_reader.readByte());
+                indTexAddPrev = m_reader.readByte();
+                indTexUseOrigLOD = m_reader.readByte();
+                indTexAlphaSel = GX::IndTexAlphaSel_t(m_reader.readByte());
             }
 
             tevStages.push_back(GX::TevStage{
@@ -850,57 +869,57 @@ void BmdFile::readMAT3()
         }
 
         // SetAlphaCompare
-        file->position(sectionStart + materialEntryIndex + 0x146);
-        uint16_t alphaTestIndex = file->readShort();
-        uint16_t blendModeIndex = file->readShort();
+        m_reader.position(sectionStart + materialEntryIndex + 0x146);
+        uint16_t alphaTestIndex = m_reader.readShort();
+        uint16_t blendModeIndex = m_reader.readShort();
 
         uint32_t alphaTestOffset = alphaTestTableOffset + alphaTestIndex * 0x08;
-        file->position(sectionStart + alphaTestOffset);
+        m_reader.position(sectionStart + alphaTestOffset);
 
-        GX::CompareType_t compareA = GX::CompareType_t(file->readByte());
-        uint8_t referenceA = file->readByte() / 0xFF; // TODO should this be a float?
-        GX::AlphaOp_t op = GX::AlphaOp_t(file->readByte());
-        GX::CompareType_t compareB = GX::CompareType_t(file->readByte());
-        uint8_t referenceB = file->readByte() / 0xFF;
+        GX::CompareType_t compareA = GX::CompareType_t(m_reader.readByte());
+        uint8_t referenceA = m_reader.readByte() / 0xFF; // TODO should this be a float?
+        GX::AlphaOp_t op = GX::AlphaOp_t(m_reader.readByte());
+        GX::CompareType_t compareB = GX::CompareType_t(m_reader.readByte());
+        uint8_t referenceB = m_reader.readByte() / 0xFF;
         GX::AlphaTest alphaTest = { op, compareA, referenceA, compareB, referenceB };
 
         // SetBlendMode
         uint32_t blendModeOffset = blendModeTableOffset + blendModeIndex * 0x04;
-        file->position(sectionStart + blendModeOffset);
+        m_reader.position(sectionStart + blendModeOffset);
 
-        GX::BlendMode_t blendMode = GX::BlendMode_t(file->readByte());
-        GX::BlendFactor_t blendSrcFactor = GX::BlendFactor_t(file->readByte());
-        GX::BlendFactor_t blendDstFactor = GX::BlendFactor_t(file->readByte());
-        GX::LogicOp_t blendLogicOp = GX::LogicOp_t(file->readByte());
+        GX::BlendMode_t blendMode = GX::BlendMode_t(m_reader.readByte());
+        GX::BlendFactor_t blendSrcFactor = GX::BlendFactor_t(m_reader.readByte());
+        GX::BlendFactor_t blendDstFactor = GX::BlendFactor_t(m_reader.readByte());
+        GX::LogicOp_t blendLogicOp = GX::LogicOp_t(m_reader.readByte());
 
-        file->position(sectionStart + cullModeTableOffset + cullModeIndex * 0x04);
-        GX::CullMode_t cullMode = GX::CullMode_t(file->readInt());
+        m_reader.position(sectionStart + cullModeTableOffset + cullModeIndex * 0x04);
+        GX::CullMode_t cullMode = GX::CullMode_t(m_reader.readInt());
 
         uint32_t zModeOffset = zModeTableOffset + zModeIndex * 4;
-        file->position(zModeOffset);
+        m_reader.position(zModeOffset);
 
-        bool depthTest = file->readByte();
-        GX::CompareType_t depthFunc = GX::CompareType_t(file->readByte());
-        bool depthWrite = file->readByte();
+        bool depthTest = m_reader.readByte();
+        GX::CompareType_t depthFunc = GX::CompareType_t(m_reader.readByte());
+        bool depthWrite = m_reader.readByte();
 
-        file->position(sectionStart + materialEntryIndex + 0x144);
-        uint16_t fogInfoIndex = file->readShort();
+        m_reader.position(sectionStart + materialEntryIndex + 0x144);
+        uint16_t fogInfoIndex = m_reader.readShort();
 
         uint32_t fogInfoOffset = fogInfoTableOffset + fogInfoIndex * 0x2C;
-        file->position(sectionStart + fogInfoOffset);
-
-        GX::FogType_t fogType = GX::FogType_t(file->readByte());
-        bool fogAdjEnabled = file->readByte();
-        uint16_t fogAdjCenter = file->readShort();
-        float fogStartZ = file->readFloat();
-        float fogEndZ = file->readFloat();
-        float fogNearZ = file->readFloat();
-        float fogFarZ = file->readFloat();
+        m_reader.position(sectionStart + fogInfoOffset);
+
+        GX::FogType_t fogType = GX::FogType_t(m_reader.readByte());
+        bool fogAdjEnabled = m_reader.readByte();
+        uint16_t fogAdjCenter = m_reader.readShort();
+        float fogStartZ = m_reader.readFloat();
+        float fogEndZ = m_reader.readFloat();
+        float fogNearZ = m_reader.readFloat();
+        float fogFarZ = m_reader.readFloat();
         QColor fogColor = readColor_RGBA8();
 
         std::array<uint16_t, 10> fogAdjTable;
         for(uint32_t j = 0; j < 10; j++)
-            fogAdjTable[j] = file->readShort();
+            fogAdjTable[j] = m_reader.readShort();
 
         GX::FogBlock fogBlock;
         bool fogProj = uint8_t(fogType) >> 3;
@@ -950,13 +969,13 @@ void BmdFile::readMAT3()
         });
     }
 
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 void BmdFile::readMDL3()
 {
-    uint32_t sectionStart = file->position() - 4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 4;
+    uint32_t sectionSize = m_reader.readInt();
 
     // this is the most important section
     // here we're going to parse it with lots of code
@@ -964,20 +983,20 @@ void BmdFile::readMDL3()
     // and uh
 
     // skip section
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 void BmdFile::readTEX1()
 {
-    uint32_t sectionStart = file->position() - 4;
-    uint32_t sectionSize = file->readInt();
+    uint32_t sectionStart = m_reader.position() - 4;
+    uint32_t sectionSize = m_reader.readInt();
 
-    uint16_t textureCount = file->readShort();
-    file->skip(0x02);
+    uint16_t textureCount = m_reader.readShort();
+    m_reader.skip(0x02);
 
-    uint32_t textureHeaderOffset = file->readInt();
+    uint32_t textureHeaderOffset = m_reader.readInt();
 
-    uint32_t nameTableOffset = file->readInt();
+    uint32_t nameTableOffset = m_reader.readInt();
     std::vector<QString> nameTable = readStringTable(sectionStart + nameTableOffset);
 
     std::vector<Sampler> samplers;
@@ -1028,48 +1047,48 @@ void BmdFile::readTEX1()
         });
     }
 
-    file->position(sectionStart + sectionSize);
+    m_reader.position(sectionStart + sectionSize);
 }
 
 GX::BTI_Texture BmdFile::readBTI(uint32_t absoluteStartIndex, const QString& name)
 {
-    file->position(absoluteStartIndex);
+    m_reader.position(absoluteStartIndex);
 
-    GX::TexFormat_t format = GX::TexFormat_t(file->readByte());
-    file->skip(0x01);
+    GX::TexFormat_t format = GX::TexFormat_t(m_reader.readByte());
+    m_reader.skip(0x01);
 
-    uint16_t width = file->readShort();
-    uint16_t height = file->readShort();
+    uint16_t width = m_reader.readShort();
+    uint16_t height = m_reader.readShort();
 
-    GX::WrapMode_t wrapS = GX::WrapMode_t(file->readByte());
-    GX::WrapMode_t wrapT = GX::WrapMode_t(file->readByte());
-    file->skip(0x01);
+    GX::WrapMode_t wrapS = GX::WrapMode_t(m_reader.readByte());
+    GX::WrapMode_t wrapT = GX::WrapMode_t(m_reader.readByte());
+    m_reader.skip(0x01);
 
-    GX::TexPalette_t paletteFormat = GX::TexPalette_t(file->readByte());
-    uint16_t paletteCount = file->readShort();
-    uint32_t paletteOffset = file->readInt();
-    file->skip(0x04);
+    GX::TexPalette_t paletteFormat = GX::TexPalette_t(m_reader.readByte());
+    uint16_t paletteCount = m_reader.readShort();
+    uint32_t paletteOffset = m_reader.readInt();
+    m_reader.skip(0x04);
 
-    GX::TexFilter_t minFilter = GX::TexFilter_t(file->readByte());
-    GX::TexFilter_t magFilter = GX::TexFilter_t(file->readByte());
+    GX::TexFilter_t minFilter = GX::TexFilter_t(m_reader.readByte());
+    GX::TexFilter_t magFilter = GX::TexFilter_t(m_reader.readByte());
 
-    float minLOD = file->readByte() / 8.f;
-    float maxLOD = file->readByte() / 8.f;
-    uint8_t mipCount = file->readByte();
-    file->skip(0x01);
+    float minLOD = m_reader.readByte() / 8.f;
+    float maxLOD = m_reader.readByte() / 8.f;
+    uint8_t mipCount = m_reader.readByte();
+    m_reader.skip(0x01);
 
-    float lodBias = file->readShort() / 100.f;
-    uint32_t dataOffset = file->readInt();
+    float lodBias = m_reader.readShort() / 100.f;
+    uint32_t dataOffset = m_reader.readInt();
 
     assert(minLOD == 0);
 
     std::span<const uint8_t> data;
     if(dataOffset != 0)
-        data = std::span<const uint8_t>(file->getContents().data() + absoluteStartIndex + dataOffset, file->getLength() - (absoluteStartIndex + dataOffset));
+        data = std::span<const uint8_t>(m_reader.data().data() + absoluteStartIndex + dataOffset, m_reader.getLength() - (absoluteStartIndex + dataOffset));
 
     std::span<const uint8_t> paletteData;
     if(paletteOffset != 0)
-        paletteData = std::span<const uint8_t>(file->getContents().data() + absoluteStartIndex + paletteOffset, absoluteStartIndex + paletteOffset + paletteCount * 2);
+        paletteData = std::span<const uint8_t>(m_reader.data().data() + absoluteStartIndex + paletteOffset, absoluteStartIndex + paletteOffset + paletteCount * 2);
 
     return {
         name, format, width, height,
@@ -1084,17 +1103,17 @@ std::vector<QString> BmdFile::readStringTable(uint32_t absoluteOffset)
 {
     std::vector<QString> ret;
 
-    file->position(absoluteOffset);
-    uint16_t stringCount = file->readShort();
+    m_reader.position(absoluteOffset);
+    uint16_t stringCount = m_reader.readShort();
     uint32_t index = 0x04;
     for(uint32_t i = 0; i < stringCount; i++)
     {
         // const hash = view.getUint16(tableIdx + 0x00);
-        file->position(absoluteOffset + index + 0x02);
-        uint16_t stringOffset = file->readShort();
+        m_reader.position(absoluteOffset + index + 0x02);
+        uint16_t stringOffset = m_reader.readShort();
 
-        file->position(absoluteOffset + stringOffset);
-        QString string = file->readString(0, "UTF-8");
+        m_reader.position(absoluteOffset + stringOffset);
+        QString string = m_reader.readString(0, "UTF-8");
         ret.push_back(string);
         index += 0x04;
     }
@@ -1105,13 +1124,13 @@ std::vector<QString> BmdFile::readStringTable(uint32_t absoluteOffset)
 
 float BmdFile::readArrayShort(uint8_t fixedPoint)
 {
-    short val = file->readShort();
+    short val = m_reader.readShort();
     return (float)(val / (float)(1 << fixedPoint));
 }
 
 float BmdFile::readArrayFloat()
 {
-    return file->readFloat();
+    return m_reader.readFloat();
 }
 
 float BmdFile::readArrayValue(uint32_t type, uint8_t fixedPoint)
@@ -1126,28 +1145,28 @@ float BmdFile::readArrayValue(uint32_t type, uint8_t fixedPoint)
 
 QColor BmdFile::readColor_RGBA8()
 {
-    int r = file->readByte() & 0xFF;
-    int g = file->readByte() & 0xFF;
-    int b = file->readByte() & 0xFF;
-    int a = file->readByte() & 0xFF;
+    int r = m_reader.readByte() & 0xFF;
+    int g = m_reader.readByte() & 0xFF;
+    int b = m_reader.readByte() & 0xFF;
+    int a = m_reader.readByte() & 0xFF;
     return QColor(r, g, b, a);
 }
 
 QColor BmdFile::readColor_RGBX8()
 {
-    int r = file->readByte() & 0xFF;
-    int g = file->readByte() & 0xFF;
-    int b = file->readByte() & 0xFF;
-    file->readByte();
+    int r = m_reader.readByte() & 0xFF;
+    int g = m_reader.readByte() & 0xFF;
+    int b = m_reader.readByte() & 0xFF;
+    m_reader.readByte();
     return QColor(qRgb(r, g, b));
 }
 
 QColor BmdFile::readColor_RGBA16()
 {
-    uint16_t r = file->readInt();
-    uint16_t g = file->readInt();
-    uint16_t b = file->readInt();
-    uint16_t a = file->readInt();
+    uint16_t r = m_reader.readInt();
+    uint16_t g = m_reader.readInt();
+    uint16_t b = m_reader.readInt();
+    uint16_t a = m_reader.readInt();
     return QColor(qRgba(r, g, b, a));
 }
 
@@ -1167,15 +1186,15 @@ QColor BmdFile::readColorValue(uint32_t type)
 
 GX::ColorChannelControl BmdFile::readColorChannel(uint32_t absoluteColorChanTableOffset, uint16_t colorChanIndex) {
     if (colorChanIndex != 0xFFFF) {
-        file->position(absoluteColorChanTableOffset + colorChanIndex * 0x08);
-        bool lightingEnabled = file->readByte();
+        m_reader.position(absoluteColorChanTableOffset + colorChanIndex * 0x08);
+        bool lightingEnabled = m_reader.readByte();
         //assert(lightingEnabled < 2);
 
-        GX::ColorSrc_t matColorSource = GX::ColorSrc_t(file->readByte());
-        uint8_t litMask = file->readByte();
-        GX::DiffuseFunction_t diffuseFunction = GX::DiffuseFunction_t(file->readByte());
+        GX::ColorSrc_t matColorSource = GX::ColorSrc_t(m_reader.readByte());
+        uint8_t litMask = m_reader.readByte();
+        GX::DiffuseFunction_t diffuseFunction = GX::DiffuseFunction_t(m_reader.readByte());
 
-        uint8_t attnFn = file->readByte();
+        uint8_t attnFn = m_reader.readByte();
 
         GX::AttenuationFunction_t attenuationFunction;
         switch(attnFn)
@@ -1194,7 +1213,7 @@ GX::ColorChannelControl BmdFile::readColorChannel(uint32_t absoluteColorChanTabl
                 assert(false); // invalid attnFn
         }
 
-        GX::ColorSrc_t ambColorSource = GX::ColorSrc_t(file->readByte());
+        GX::ColorSrc_t ambColorSource = GX::ColorSrc_t(m_reader.readByte());
 
         return { lightingEnabled, matColorSource, ambColorSource, litMask, diffuseFunction, attenuationFunction };
     } else {
@@ -1210,9 +1229,5 @@ GX::ColorChannelControl BmdFile::readColorChannel(uint32_t absoluteColorChanTabl
 
 glm::vec3 BmdFile::readVec3()
 {
-    return glm::vec3(
-        file->readFloat(),
-        file->readFloat(),
-        file->readFloat()
-    );
+    return m_reader.readStruct<glm::vec3>();
 }
@@ -0,0 +1,197 @@
+#include "io/ByteStrings.h"
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <QTextCodec>
+
+namespace
+{
+    enum class Encoding
+    {
+        UTF8,
+        ShiftJIS,
+        Other
+    };
+
+    Encoding encodingOf(const char* enc)
+    {
+        if(strcmp(enc, "ASCII") == 0 || strcmp(enc, "UTF-8") == 0)
+            return Encoding::UTF8;
+
+        if(strcmp(enc, "Shift-JIS") == 0 || strcmp(enc, "Shift_JIS") == 0 || strcmp(enc, "SJIS") == 0)
+            return Encoding::ShiftJIS;
+
+        return Encoding::Other;
+    }
+
+    // codecForName takes a lock and searches every codec, so remember the last one per thread
+    QTextCodec* cachedCodec(const char* enc)
+    {
+        thread_local std::string lastName;
+        thread_local QTextCodec* lastCodec = nullptr;
+
+        if(lastCodec == nullptr || lastName != enc)
+        {
+            lastName = enc;
+            lastCodec = QTextCodec::codecForName(enc);
+        }
+
+        return lastCodec;
+    }
+
+    // Shift-JIS lead bytes. everything else is a single-byte character
+    constexpr bool isLeadByte(uint8_t b)
+    {
+        return (b >= 0x81 && b <= 0x9F) || (b >= 0xE0 && b <= 0xFC);
+    }
+
+    // Lookup tables for Shift-JIS, built once from Qt's codec so we map exactly like it does.
+    // After that, decoding is one table lookup per character, with no codec or decoder state.
+    struct ShiftJisTables
+    {
+        std::array<char16_t, 0x100> single {};  // byte -> char
+        std::vector<char16_t> pairs;            // (lead << 8 | trail) -> char, 0 if unmapped
+        std::vector<uint16_t> reverse;          // char -> code (< 0x100 for single bytes), 0 if unmapped
+
+        ShiftJisTables() : pairs(0x10000, 0), reverse(0x10000, 0)
+        {
+            for(uint32_t b = 0; b < 0x80; b++)
+                single[b] = char16_t(b);
+
+            QTextCodec* codec = QTextCodec::codecForName("Shift-JIS");
+            if(codec == nullptr)
+                return; // Qt was built without it, ASCII will still work
+
+            for(uint32_t b = 0; b < 0x100; b++)
+            {
+                if(isLeadByte(b))
+                    continue;
+
+                char c = char(b);
+                QString str = codec->toUnicode(&c, 1);
+                single[b] = (str.length() == 1) ? char16_t(str[0].unicode()) : char16_t(QChar::ReplacementCharacter);
+            }
+
+            for(uint32_t lead = 0x81; lead <= 0xFC; lead++)
+            {
+                if(!isLeadByte(lead))
+                    continue;
+
+                for(uint32_t trail = 0x40; trail <= 0xFC; trail++)
+                {
+                    char bytes[] = { char(lead), char(trail) };
+                    QString str = codec->toUnicode(bytes, 2);
+
+                    if(str.length() == 1 && str[0].unicode() != QChar::ReplacementCharacter)
+                        pairs[(lead << 8) | trail] = str[0].unicode();
+                }
+            }
+
+            // first come, first served, so single bytes and the lowest code win for duplicated chars
+            for(uint32_t b = 1; b < 0x100; b++)
+            {
+                if(!isLeadByte(b) && reverse[single[b]] == 0)
+                    reverse[single[b]] = b;
+            }
+
+            for(uint32_t code = 0; code < 0x10000; code++)
+            {
+                if(pairs[code] != 0 && reverse[pairs[code]] == 0)
+                    reverse[pairs[code]] = code;
+            }
+        }
+    };
+
+    const ShiftJisTables& shiftJisTables()
+    {
+        static const ShiftJisTables tables;
+        return tables;
+    }
+
+    QString decodeShiftJis(std::span<const uint8_t> bytes)
+    {
+        const ShiftJisTables& tables = shiftJisTables();
+
+        QString ret(bytes.size(), Qt::Uninitialized); // never more chars than bytes
+        QChar* out = ret.data();
+
+        uint32_t i = 0;
+        while(i < bytes.size())
+        {
+            uint8_t b = bytes[i++];
+
+            if(!isLeadByte(b))
+            {
+                *out++ = QChar(tables.single[b]);
+                continue;
+            }
+
+            char16_t c = 0;
+            if(i < bytes.size())
+                c = tables.pairs[(b << 8) | bytes[i++]];
+
+            *out++ = QChar(c != 0 ? c : char16_t(QChar::ReplacementCharacter));
+        }
+
+        ret.resize(out - ret.data());
+        return ret;
+    }
+
+    QByteArray encodeShiftJis(const QString& str)
+    {
+        const ShiftJisTables& tables = shiftJisTables();
+
+        QByteArray ret;
+        ret.resize(str.length() * 2); // never more than two bytes per char
+        char* out = ret.data();
+
+        for(QChar qc : str)
+        {
+            char16_t c = qc.unicode();
+            uint16_t code = tables.reverse[c];
+
+            if(c == 0)
+                *out++ = 0;
+            else if(code == 0)
+                *out++ = '?'; // same as QTextCodec
+            else if(code < 0x100)
+                *out++ = char(code);
+            else
+            {
+                *out++ = char(code >> 8);
+                *out++ = char(code & 0xFF);
+            }
+        }
+
+        ret.resize(out - ret.data());
+        return ret;
+    }
+}
+
+QString ByteStrings::decode(std::span<const uint8_t> bytes, const char* enc)
+{
+    switch(encodingOf(enc))
+    {
+        case Encoding::UTF8:
+            return QString::fromUtf8((const char*)bytes.data(), bytes.size());
+        case Encoding::ShiftJIS:
+            return decodeShiftJis(bytes);
+        default:
+            return cachedCodec(enc)->toUnicode((const char*)bytes.data(), bytes.size());
+    }
+}
+
+QByteArray ByteStrings::encode(const QString& str, const char* enc)
+{
+    switch(encodingOf(enc))
+    {
+        case Encoding::UTF8:
+            return str.toUtf8();
+        case Encoding::ShiftJIS:
+            return encodeShiftJis(str);
+        default:
+            return cachedCodec(enc)->fromUnicode(str);
+    }
+}
@@ -0,0 +1,115 @@
+#include "io/ByteSwap.h"
+
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLACKHOLE_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // 16 bytes at a time, whatever instruction set we have
+#if defined(__SSSE3__)
+    inline void swapBlock16(const uint8_t* src, uint8_t* dst)
+    {
+        const __m128i mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        __m128i v = _mm_loadu_si128((const __m128i*) src);
+        _mm_storeu_si128((__m128i*) dst, _mm_shuffle_epi8(v, mask));
+    }
+
+    inline void swapBlock32(const uint8_t* src, uint8_t* dst)
+    {
+        const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        __m128i v = _mm_loadu_si128((const __m128i*) src);
+        _mm_storeu_si128((__m128i*) dst, _mm_shuffle_epi8(v, mask));
+    }
+#elif defined(BLACKHOLE_SSE2)
+    inline __m128i swapHalves(__m128i v)
+    {
+        return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+
+    inline void swapBlock16(const uint8_t* src, uint8_t* dst)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) src);
+        _mm_storeu_si128((__m128i*) dst, swapHalves(v));
+    }
+
+    inline void swapBlock32(const uint8_t* src, uint8_t* dst)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) src);
+        v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16)); // swap the shorts...
+        _mm_storeu_si128((__m128i*) dst, swapHalves(v));                // ...then the bytes in them
+    }
+#elif defined(__ARM_NEON)
+    inline void swapBlock16(const uint8_t* src, uint8_t* dst)
+    {
+        vst1q_u8(dst, vrev16q_u8(vld1q_u8(src)));
+    }
+
+    inline void swapBlock32(const uint8_t* src, uint8_t* dst)
+    {
+        vst1q_u8(dst, vrev32q_u8(vld1q_u8(src)));
+    }
+#else
+    inline void swapBlock16(const uint8_t* src, uint8_t* dst)
+    {
+        uint16_t vals[8];
+        memcpy(vals, src, sizeof(vals));
+        for(uint16_t& val : vals)
+            val = ByteSwap::swap16(val);
+        memcpy(dst, vals, sizeof(vals));
+    }
+
+    inline void swapBlock32(const uint8_t* src, uint8_t* dst)
+    {
+        uint32_t vals[4];
+        memcpy(vals, src, sizeof(vals));
+        for(uint32_t& val : vals)
+            val = ByteSwap::swap32(val);
+        memcpy(dst, vals, sizeof(vals));
+    }
+#endif
+}
+
+void ByteSwap::copySwap16(const void* src, void* dst, size_t count)
+{
+    const uint8_t* in = (const uint8_t*) src;
+    uint8_t* out = (uint8_t*) dst;
+
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+        swapBlock16(in + i * 2, out + i * 2);
+
+    // leftovers
+    for(; i < count; i++)
+    {
+        uint16_t val;
+        memcpy(&val, in + i * 2, 2);
+        val = swap16(val);
+        memcpy(out + i * 2, &val, 2);
+    }
+}
+
+void ByteSwap::copySwap32(const void* src, void* dst, size_t count)
+{
+    const uint8_t* in = (const uint8_t*) src;
+    uint8_t* out = (uint8_t*) dst;
+
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4)
+        swapBlock32(in + i * 4, out + i * 4);
+
+    for(; i < count; i++)
+    {
+        uint32_t val;
+        memcpy(&val, in + i * 4, 4);
+        val = swap32(val);
+        memcpy(out + i * 4, &val, 4);
+    }
+}
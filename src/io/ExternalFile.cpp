@@ -1,36 +1,63 @@
 #include "io/ExternalFile.h"
 
+#include <QFile>
+#include <QSaveFile>
+
 ExternalFile::ExternalFile(const QString& filePath)
-        : m_filePath(filePath), m_file(m_filePath)
+        : m_filePath(filePath)
 {
-    // don't open automatically so as to allow Dolphin to work
-    m_file.open(QIODevice::ReadOnly);
-    QByteArray bytes = m_file.readAll();
+    if(map())
+        return;
 
-    m_contents = std::vector<uint8_t>(bytes.begin(), bytes.end());
-    m_file.close();
-}
+    // some files can't be mapped (empty ones, odd filesystems...), so read those into memory
+    QFile file(m_filePath);
+    file.open(QIODevice::ReadOnly);
+    QByteArray bytes = file.readAll();
 
-void ExternalFile::save()
-{
-    m_file.open(QIODevice::WriteOnly);
-    m_file.write(QByteArray((const char*)m_contents.data(), m_contents.size()));
-    m_file.close();
+    setContents(std::vector<uint8_t>(bytes.begin(), bytes.end()));
+    file.close();
+
+    markSaved(); // it's what's on disk
 }
 
-void ExternalFile::close()
+bool ExternalFile::map()
 {
-    m_file.close();
+    // the QFile owns the mapping and unmaps it when destroyed,
+    // so it lives as long as anything still reads from the view
+    auto file = std::make_shared<QFile>(m_filePath);
+    if(!file->open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 size = file->size();
+    uchar* mapped = (size > 0) ? file->map(0, size) : nullptr;
+
+    // a mapping stays valid after closing, and we don't keep the file open so as to allow Dolphin to work
+    file->close();
+
+    if(mapped == nullptr)
+        return false;
+
+    borrow(std::span<const uint8_t>(mapped, size), file);
+    return true;
 }
 
-uint32_t ExternalFile::getLength() const
+void ExternalFile::save()
 {
-    return m_file.size();
+    // nothing was written, so the mapping (or what we read) is still what's on disk.
+    // a borrowed view isn't enough to go by, shareContents() borrows our own bytes too
+    if(!isModified())
+        return;
+
+    // write to a temporary file and swap it in, so readers that still map the old file keep valid pages
+    QSaveFile file(m_filePath);
+    file.open(QIODevice::WriteOnly);
+    file.write((const char*) m_view.data(), m_view.size());
+
+    if(file.commit())
+        markSaved();
 }
 
-void ExternalFile::setLength(uint32_t length)
+void ExternalFile::close()
 {
-    // TODO this function does not exist in QFile... do we even need it?
-    //m_file.setLength(length);
-    assert(false);
+    // nothing to do, the file is never kept open
 }
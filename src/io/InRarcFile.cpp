@@ -1,9 +1,13 @@
 #include "io/InRarcFile.h"
 
 InRarcFile::InRarcFile(RarcFile* fs, const QString& fullName)
-        : MemoryFile(fs->getFileContents(fullName)), m_fs(fs), m_fullName(fullName)
+        : MemoryFile(), m_fs(fs), m_fullName(fullName)
 {
+    // read straight from the archive's buffer, writes copy it first
+    std::shared_ptr<const void> owner;
+    std::span<const uint8_t> bytes = fs->getFileView(fullName, owner);
 
+    borrow(bytes, std::move(owner));
 }
 
 void InRarcFile::save()
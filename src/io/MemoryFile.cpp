@@ -2,7 +2,7 @@
 
 MemoryFile::MemoryFile(const std::vector<uint8_t>& buffer)
 {
-    m_contents = buffer;
+    setContents(buffer);
 }
 
 void MemoryFile::save()
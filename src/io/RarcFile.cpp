@@ -1,106 +1,216 @@
 #include "io/RarcFile.h"
 
-#include <stack>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
 
+#include "io/ByteStrings.h"
 #include "io/Yaz0File.h"
 #include "io/InRarcFile.h"
 #include "Util.h"
 
+namespace
+{
+    // ASCII gets a quick path, since that's nearly every name
+    char16_t foldCase(char16_t c)
+    {
+        if(c < 0x80)
+            return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+
+        return QChar::toCaseFolded(uint(c));
+    }
+
+    // where the part after the root dir starts, or 0 if the path is just the root
+    template<typename Char>
+    uint32_t rootEnd(const Char* path, uint32_t length)
+    {
+        // skip the leading slash, then the root's name
+        for(uint32_t i = 1; i < length; i++)
+        {
+            if(path[i] == '/')
+                return i;
+        }
+
+        return 0;
+    }
+
+    const char16_t ROOT_PATH[] = u"/";
+}
+
 RarcFile::RarcFile(const QString& rarcFilePath) : m_filePath(rarcFilePath)
 {
-    file = new Yaz0File(rarcFilePath);
+    file = std::make_shared<Yaz0File>(rarcFilePath);
     file->setBigEndian(true);
 
-    uint32_t magic = file->readInt();
-    assert(magic == 0x52415243); // File signature is wrong
+    // everything below checks the archive's offsets before following them, so a broken one throws instead
+    if(file->getLength() < 0x40)
+        throw std::runtime_error("Rarc: file too short for a header");
 
-    file->position(0xC);
-    uint32_t fileDataOffset = file->readInt() + 0x20;
-    file->position(0x20);
+    BigEndianReader reader(file->slice(0, 0x40));
 
-    uint32_t numDirNodes = file->readInt();
-    dirEntries.reserve(numDirNodes);
-    uint32_t dirNodesOffset = file->readInt() + 0x20;
+    uint32_t magic = reader.readInt();
+    if(magic != 0x52415243)
+        throw std::runtime_error("Rarc: file signature is wrong");
 
-    uint32_t numFileEntries = file->readInt();
+    reader.position(0xC);
+    uint64_t fileDataEnd = uint64_t(reader.readInt()) + 0x20;
+    if(fileDataEnd < 0x40 || fileDataEnd > file->getLength())
+        throw std::runtime_error("Rarc: file data offset out of bounds");
+
+    uint32_t fileDataOffset = fileDataEnd;
+
+    // the tables all come before the file data, so that's as far as the archive gets decoded for now
+    reader = BigEndianReader(file->slice(0, fileDataOffset), 0x20);
+
+    // the info block is just eight ints, grab them all at once
+    std::array<uint32_t, 8> info;
+    reader.readInts(info);
+
+    uint32_t numDirNodes = info[0];
+    uint32_t dirNodesOffset = info[1] + 0x20;
+
+    uint32_t numFileEntries = info[2];
+    uint32_t fileEntriesOffset = info[3] + 0x20;
+
+    uint32_t stringTableOffset = info[5] + 0x20;
+    m_unk38 = info[6];
+
+    // the tables all have to fit before the file data
+    auto fits = [&](uint32_t offset, uint64_t size)
+    {
+        return offset >= 0x40 && uint64_t(offset) + size <= fileDataOffset;
+    };
+
+    if(numDirNodes == 0 || !fits(dirNodesOffset, uint64_t(numDirNodes) * 0x10))
+        throw std::runtime_error("Rarc: directory nodes out of bounds");
+    if(!fits(fileEntriesOffset, uint64_t(numFileEntries) * 0x14))
+        throw std::runtime_error("Rarc: file entries out of bounds");
+    if(!fits(stringTableOffset, 0))
+        throw std::runtime_error("Rarc: string table out of bounds");
+
+    m_dirs.reserve(numDirNodes);
+    dirEntries.reserve(numDirNodes);
+    m_files.reserve(numFileEntries);
     fileEntries.reserve(numFileEntries);
-    uint32_t fileEntriesOffset = file->readInt() + 0x20;
 
-    file->skip(0x4);
+    // every name lives in the string table, so decode the whole table once and look names up by offset
+    uint32_t stringTableSize = fileDataOffset - stringTableOffset;
+    std::span<const uint8_t> stringTable = reader.slice(stringTableOffset, fileDataOffset);
+
+    std::vector<QString> strings(stringTableSize);
+    for(uint32_t start = 0; start < stringTableSize; )
+    {
+        const uint8_t* end = (const uint8_t*) memchr(stringTable.data() + start, 0, stringTableSize - start);
+        if(end == nullptr)
+            break;
+
+        uint32_t length = end - (stringTable.data() + start);
+        strings[start] = ByteStrings::decode(stringTable.subspan(start, length), "ASCII");
+        start += length + 1;
+    }
+
+    auto stringAt = [&](uint32_t offset)
+    {
+        if(offset < stringTableSize && !strings[offset].isNull())
+            return strings[offset];
+
+        // a name starting partway into another one, which nothing we know of does
+        if(offset >= stringTableSize || memchr(stringTable.data() + offset, 0, stringTableSize - offset) == nullptr)
+            throw std::runtime_error("Rarc: name out of bounds");
 
-    uint32_t stringTableOffset = file->readInt() + 0x20;
-    m_unk38 = file->readInt();
+        reader.position(stringTableOffset + offset);
+        return reader.readString(0, "ASCII");
+    };
 
-    DirEntry* root = new DirEntry();
+    reader.position(dirNodesOffset + 0x06);
+    uint16_t rnOffset = reader.readShort();
 
-    file->position(dirNodesOffset + 0x06);
-    uint16_t rnOffset = file->readShort();
+    QString rootName = stringAt(rnOffset);
+    m_dirs.push_back(DirEntry{ NONE, rootName, '/' + rootName, 0 });
 
-    file->position(stringTableOffset + rnOffset);
-    root->name = file->readString(0, "ASCII");
-    root->fullName = '/' + root->name;
-    root->tempID = 0;
+    dirEntries.insert(std::make_pair(u"/", 0));
 
-    dirEntries.insert(std::make_pair("/", root));
+    // directory entries point at their node by index, so walk the tree from the root
+    // with the nodes indexed by that, instead of searching for each one's parent
+    std::vector<uint32_t> nodes(numDirNodes, NONE);
+    std::vector<uint32_t> pending;
 
-    for(int i = 0; i < numDirNodes; i++)
+    if(numDirNodes > 0)
     {
-        DirEntry* parentDir;
-        for(auto& [key, entry] : dirEntries)
-        {
-            if(entry->tempID == i)
-            {
-                parentDir = entry;
-                break;
-            }
-        }
+        nodes[0] = 0;
+        pending.push_back(0);
+    }
 
-        file->position(dirNodesOffset + (i * 0x10) + 10);
+    while(!pending.empty())
+    {
+        uint32_t i = pending.back();
+        pending.pop_back();
+
+        uint32_t parentDir = nodes[i];
+
+        reader.position(dirNodesOffset + (i * 0x10) + 10);
+
+        uint16_t numEntries = reader.readShort();
+        uint32_t firstEntry = reader.readInt();
+        if(uint64_t(firstEntry) + numEntries > numFileEntries)
+            throw std::runtime_error("Rarc: directory entries out of bounds");
 
-        uint16_t numEntries = file->readShort();
-        uint32_t firstEntry = file->readInt();
         for(int j = 0; j < numEntries; j++)
         {
             uint32_t entryOffset = fileEntriesOffset + ((j + firstEntry) * 0x14);
-            file->position(entryOffset);
-            file->skip(0x4);
+            reader.position(entryOffset);
+            reader.skip(0x4);
 
-            uint32_t entryType = file->readShort() & 0xFFFF; // TODO why this AND and not u16?
-            uint32_t nameOffset = file->readShort() & 0xFFFF;
-            uint32_t dataOffset = file->readInt();
-            uint32_t dataSize = file->readInt();
+            uint32_t entryType = reader.readShort();
+            uint32_t nameOffset = reader.readShort();
+            uint32_t dataOffset = reader.readInt();
+            uint32_t dataSize = reader.readInt();
 
-            file->position(stringTableOffset + nameOffset);
-            QString name = file->readString(0, "ASCII");
+            QString name = stringAt(nameOffset);
             if(name == "." || name == "..")
                 continue;
 
-            QString fullName = parentDir->fullName + '/' + name;
+            QString fullName = m_dirs[parentDir].fullName + '/' + name;
 
             if(entryType == 0x0200)
             {
-                DirEntry* d = new DirEntry{
+                uint32_t d = m_dirs.size();
+                m_dirs.push_back(DirEntry{
                     parentDir,
                     name,
                     fullName,
                     dataOffset
-                };
+                });
 
                 dirEntries.insert(std::make_pair(pathToKey(fullName), d));
-                parentDir->childrenDirs.push_back(d);
+                m_dirs[parentDir].childrenDirs.push_back(d);
+
+                // each node gets visited once, even if a broken archive links it twice
+                if(dataOffset < numDirNodes && nodes[dataOffset] == NONE)
+                {
+                    nodes[dataOffset] = d;
+                    pending.push_back(dataOffset);
+                }
             }
             else
             {
-                FileEntry* f = new FileEntry{
+                if(uint64_t(fileDataOffset) + dataOffset + dataSize > file->getLength())
+                    throw std::runtime_error("Rarc: file data out of bounds");
+
+                uint32_t f = m_files.size();
+                m_files.push_back(FileEntry{
                     parentDir,
                     fileDataOffset + dataOffset,
                     dataSize,
+                    entryOffset,
                     name,
                     fullName
-                };
+                });
 
                 fileEntries.insert(std::make_pair(pathToKey(fullName), f));
-                parentDir->childrenFiles.push_back(f);
+                m_dirs[parentDir].childrenFiles.push_back(f);
             }
         }
     }
@@ -108,192 +218,277 @@ RarcFile::RarcFile(const QString& rarcFilePath) : m_filePath(rarcFilePath)
 
 void RarcFile::save()
 {
-    // load all files that haven't been read yet
-    for(auto& [key, fileEntry] : fileEntries)
+    // edits that leave every file in its slot just get written over the old bytes
+    if(!patchInPlace())
+        rebuild();
+
+    // nothing was edited, so don't recompress the archive just to write the same bytes
+    if(file->isModified())
+        file->save();
+}
+
+bool RarcFile::patchInPlace()
+{
+    // anything that adds or moves names or entries needs the whole layout redone
+    if(m_layoutChanged || m_deduplicate)
+        return false;
+
+    // sizes as they are in the archive, dirty files have their new one in dataSize
+    auto archivedSize = [&](const FileEntry& fileEntry)
     {
-        if(!fileEntry->data.empty())
-            continue;
+        return BigEndianReader(file->slice(fileEntry.entryOffset, fileEntry.entryOffset + 0x14), 0x0C).readInt();
+    };
 
-        file->position(fileEntry->dataOffset);
-        fileEntry->data = file->readBytes(fileEntry->dataSize);
+    // going by the index skips nodes that were removed
+    std::vector<FileEntry*> dirty;
+    for(auto& [key, index] : fileEntries)
+    {
+        if(m_files[index].data != nullptr)
+            dirty.push_back(&m_files[index]);
     }
 
-    uint32_t dirOffset = 0x40;
-    uint32_t fileOffset = dirOffset + align32(dirEntries.size() * 0x10);
-    uint32_t stringOffset = fileOffset + align32((fileEntries.size() + (dirEntries.size() * 3) - 1) * 0x14);
+    if(dirty.empty())
+        return true;
 
-    uint32_t dataOffset = stringOffset;
-    uint32_t dataLength = 0;
+    // where every file's bytes start. a file only owns its aligned slot if no other file's start in it:
+    // other tools don't always pad to 32 bytes, and deduplicated archives have files sharing their bytes
+    std::vector<uint32_t> dataStarts;
+    for(auto& [key, index] : fileEntries)
+    {
+        if(archivedSize(m_files[index]) != 0)
+            dataStarts.push_back(m_files[index].dataOffset);
+    }
 
-    for(const auto& [key, dirEntry] : dirEntries)
-        dataOffset += dirEntry->name.length() + 1;
+    std::sort(dataStarts.begin(), dataStarts.end());
 
-    for(const auto& [key, fileEntry] : fileEntries)
+    for(FileEntry* fileEntry : dirty)
     {
-        dataOffset += fileEntry->name.length() + 1;
-        dataLength += align32(fileEntry->dataSize);
+        uint32_t slotSize = align32(archivedSize(*fileEntry));
+
+        if(align32(fileEntry->dataSize) != slotSize
+                || uint64_t(fileEntry->dataOffset) + slotSize > file->getLength())
+            return false;
+
+        auto first = std::lower_bound(dataStarts.begin(), dataStarts.end(), fileEntry->dataOffset);
+        auto last = std::lower_bound(first, dataStarts.end(), fileEntry->dataOffset + slotSize);
+        if(last - first > 1)
+            return false;
     }
-    dataOffset += 0x5;
-    dataOffset = align32(dataOffset);
-
-    uint32_t dirSubOffset = 0, fileSubOffset = 0, stringSubOffset = 0, dataSubOffset = 0;
-
-    file->setLength(dataOffset + dataLength);
-
-
-    // Write RARC header (some parts we go back to later)
-    file->position(0);
-    file->writeInt(0x52415243); // RARC magic
-    file->writeInt(dataOffset + dataLength);
-    file->writeInt(0x00000020);
-    file->writeInt(dataOffset - 0x20);
-    file->writeInt(dataLength);
-    file->writeInt(dataLength);
-    file->writeInt(0x00000000); // TODO we should skip here
-    file->writeInt(0x00000000);
-    file->writeInt(dirEntries.size());
-    file->writeInt(dirOffset - 0x20);
-    file->writeInt(fileEntries.size() + (dirEntries.size() * 3) - 1);
-    file->writeInt(fileOffset - 0x20);
-    file->writeInt(dataOffset - stringOffset);
-    file->writeInt(stringOffset - 0x20);
-    file->writeInt(m_unk38);
-    file->writeInt(0x00000000); // TODO we should skip here
-
-    file->position(stringOffset);
-    file->writeString(".", "ASCII");
-    file->writeString("..", "ASCII");
-    stringSubOffset += 0x5;
-
-    std::stack<Iterator<DirEntry*>> dirStack;
-
-    std::vector<DirEntry*> dirEntriesVector;
-    dirEntriesVector.reserve(dirEntries.size());
-    for(auto& [key, dirEntry] : dirEntries)
-        dirEntriesVector.push_back(dirEntry);
-
-    DirEntry* curDir = dirEntriesVector[0];
-    int c = 1;
-    while(curDir->parentDir != nullptr)
-        curDir = dirEntriesVector[c++]; // haha c++
 
-    uint16_t fileID = 0;
-    while(true)
+    // the new bytes, zeros over whatever's left of the old ones, and the new size in the entry
+    static const std::array<uint8_t, 0x20> zeros = {};
+
+    for(FileEntry* fileEntry : dirty)
+    {
+        file->position(fileEntry->dataOffset);
+        file->writeBytes(*fileEntry->data);
+        file->writeBytes(std::span(zeros).first(align32(fileEntry->dataSize) - fileEntry->dataSize));
+
+        file->position(fileEntry->entryOffset + 0x0C);
+        file->writeInt(fileEntry->dataSize);
+
+        fileEntry->data.reset(); // release RAM
+    }
+
+    return true;
+}
+
+void RarcFile::rebuild()
+{
+    // lay everything out first. nodes go depth first from the root, which is what gives them their IDs
+    std::vector<DirEntry*> dirOrder;
+    dirOrder.reserve(dirEntries.size());
+
+    // nothing gets added to m_dirs or m_files while saving, so pointers into them hold until the end
+    std::vector<uint32_t> pending = { 0 };
+    while(!pending.empty())
+    {
+        DirEntry* dir = &m_dirs[pending.back()];
+        pending.pop_back();
+
+        dir->tempID = dirOrder.size();
+        dirOrder.push_back(dir);
+
+        // reversed, so the first child comes off the stack first
+        pending.insert(pending.end(), dir->childrenDirs.rbegin(), dir->childrenDirs.rend());
+    }
+
+    // the string table, in the order the old writer used: each dir's name then its files' names.
+    // dirs keep their name offset in tempNameOffset, as their parent's entry needs it before they're written
+    std::vector<uint8_t> strings;
+    BigEndianWriter stringWriter(strings);
+    stringWriter.writeBytes(std::span((const uint8_t*) ".\0..\0", 5));
+
+    std::vector<uint32_t> fileNameOffsets;
+    fileNameOffsets.reserve(fileEntries.size());
+
+    // where each file's bytes go in the data section. RARC entries are free to share them,
+    // so when deduplicating a file identical to an earlier one just gets its offset
+    std::vector<uint32_t> fileDataOffsets;
+    fileDataOffsets.reserve(fileEntries.size());
+
+    std::unordered_map<std::string_view, uint32_t> payloadOffsets;
+
+    uint32_t numFiles = 0;
+    uint32_t dataLength = 0;
+
+    for(DirEntry* dir : dirOrder)
     {
-        // write the directory node
-        curDir->tempID = dirSubOffset / 0x10;
-        file->position(dirOffset + dirSubOffset);
-        file->writeInt((curDir->tempID == 0) ? 0x524F4F54 : dirMagic(curDir->name));
-        file->writeInt(stringSubOffset);
-        file->writeShort(nameHash(curDir->name));
-        file->writeShort(2 + curDir->childrenDirs.size() + curDir->childrenFiles.size()); // acount for . and ..
-        file->writeInt(fileSubOffset / 0x14);
-        dirSubOffset += 0x10;
-
-        if(curDir->tempID > 0)
+        dir->tempNameOffset = stringWriter.position();
+        stringWriter.writeString(dir->name, "ASCII");
+        stringWriter.writeByte(0);
+
+        for(uint32_t f : dir->childrenFiles)
         {
-            file->position(curDir->tempNameOffset);
-            file->writeShort(stringSubOffset);
-            file->writeInt(curDir->tempID);
+            const FileEntry& fileEntry = m_files[f];
+
+            fileNameOffsets.push_back(stringWriter.position());
+            stringWriter.writeString(fileEntry.name, "ASCII");
+            stringWriter.writeByte(0);
+
+            numFiles++;
+
+            if(m_deduplicate)
+            {
+                std::span<const uint8_t> bytes = fileBytes(fileEntry);
+                auto [it, added] = payloadOffsets.try_emplace(std::string_view((const char*) bytes.data(), bytes.size()), dataLength);
+
+                if(!added)
+                {
+                    fileDataOffsets.push_back(it->second);
+                    continue;
+                }
+            }
+
+            fileDataOffsets.push_back(dataLength);
+            dataLength += align32(fileEntry.dataSize);
         }
+    }
 
-        file->position(stringOffset + stringSubOffset);
-        stringSubOffset += file->writeString(curDir->name, "ASCII");
+    uint32_t numDirs = dirOrder.size();
+    uint32_t numEntries = numFiles + (numDirs * 3) - 1; // every dir has . and .., and all but the root are in their parent
 
-        // write the child file & dir entries
-        file->position(fileOffset + fileSubOffset);
-        for(DirEntry* dirEntry : curDir->childrenDirs)
+    uint32_t dirOffset = 0x40;
+    uint32_t fileOffset = dirOffset + align32(numDirs * 0x10);
+    uint32_t stringOffset = fileOffset + align32(numEntries * 0x14);
+    uint32_t dataOffset = align32(stringOffset + strings.size());
+    uint32_t totalSize = dataOffset + dataLength;
+
+    // build the new archive in one buffer. untouched files get copied straight out of the old one,
+    // so at worst this holds the old archive, the new one and whatever files were edited
+    std::vector<uint8_t> out(totalSize);
+    BigEndianWriter writer(out);
+
+    std::array<uint32_t, 16> header = {
+        0x52415243, // RARC magic
+        totalSize,
+        0x00000020,
+        dataOffset - 0x20,
+        dataLength,
+        dataLength,
+        0x00000000,
+        0x00000000,
+        numDirs,
+        dirOffset - 0x20,
+        numEntries,
+        fileOffset - 0x20,
+        dataOffset - stringOffset,
+        stringOffset - 0x20,
+        m_unk38,
+        0x00000000
+    };
+    writer.writeInts(header);
+
+    writer.position(stringOffset);
+    writer.writeBytes(strings);
+
+    uint32_t entryIndex = 0;
+    uint32_t dataWritten = 0;
+    uint32_t fileIndex = 0;
+    uint16_t fileID = 0;
+
+    for(DirEntry* dir : dirOrder)
+    {
+        // the directory node
+        writer.position(dirOffset + (dir->tempID * 0x10));
+        writer.writeInt((dir->tempID == 0) ? 0x524F4F54 : dirMagic(dir->name));
+        writer.writeInt(dir->tempNameOffset);
+        writer.writeShort(nameHash(dir->name));
+        writer.writeShort(2 + dir->childrenDirs.size() + dir->childrenFiles.size()); // acount for . and ..
+        writer.writeInt(entryIndex);
+
+        // its child dir & file entries, then . and ..
+        writer.position(fileOffset + (entryIndex * 0x14));
+        for(uint32_t d : dir->childrenDirs)
         {
-            file->writeShort(0xFFFF);
-            file->writeShort(nameHash(dirEntry->name));
-            file->writeShort(0x0200);
-            dirEntry->tempNameOffset = file->position();
-            file->skip(0x6);
-            file->writeInt(0x00000010);
-            file->writeInt(0x00000000); // TODO skip?
-            fileSubOffset += 0x14;
+            const DirEntry& dirEntry = m_dirs[d];
+
+            writer.writeShort(0xFFFF);
+            writer.writeShort(nameHash(dirEntry.name));
+            writer.writeShort(0x0200);
+            writer.writeShort(dirEntry.tempNameOffset);
+            writer.writeInt(dirEntry.tempID);
+            writer.writeInt(0x00000010);
+            writer.writeInt(0x00000000);
         }
 
-        for(FileEntry* fileEntry : curDir->childrenFiles)
+        for(uint32_t f : dir->childrenFiles)
         {
-            file->position(fileOffset + fileSubOffset);
-            file->writeShort(fileID);
-            file->writeShort(nameHash(fileEntry->name));
-            file->writeShort(0x1100);
-            file->writeShort(stringSubOffset);
-            file->writeInt(dataSubOffset);
-            file->writeInt(fileEntry->dataSize);
-            file->writeInt(0x00000000); // TODO skip?
-            fileSubOffset += 0x14;
+            FileEntry& fileEntry = m_files[f];
 
-            // make sure every file has a unique ID
-            fileID++;
+            uint32_t dataSubOffset = fileDataOffsets[fileIndex];
+            fileEntry.entryOffset = writer.position();
 
-            file->position(stringOffset + stringSubOffset);
-            stringSubOffset += file->writeString(fileEntry->name, "ASCII");
+            writer.writeShort(fileID++); // make sure every file has a unique ID
+            writer.writeShort(nameHash(fileEntry.name));
+            writer.writeShort(0x1100);
+            writer.writeShort(fileNameOffsets[fileIndex++]);
+            writer.writeInt(dataSubOffset);
+            writer.writeInt(fileEntry.dataSize);
+            writer.writeInt(0x00000000);
 
-            file->position(dataOffset + dataSubOffset);
-            fileEntry->dataOffset = file->position();
-
-            std::vector<uint8_t> fileData(fileEntry->data);
+            // slots are handed out in this same order, so one behind us is a duplicate that's already there
+            if(dataSubOffset < dataWritten)
+                continue;
 
-            file->writeBytes(fileData);
-            dataSubOffset += align32(fileEntry->dataSize);
+            std::span<const uint8_t> bytes = fileBytes(fileEntry);
+            memcpy(out.data() + dataOffset + dataSubOffset, bytes.data(), bytes.size());
 
-            // release RAM
-            fileEntry->data.clear();
+            dataWritten = dataSubOffset + align32(fileEntry.dataSize);
         }
 
-        file->position(fileOffset + fileSubOffset);
-        file->writeShort(0xFFFF);
-        file->writeShort(0x002E);
-        file->writeShort(0x0200);
-        file->writeShort(0x0000);
-        file->writeInt(curDir->tempID);
-        file->writeInt(0x00000010);
-        file->writeInt(0x00000000);
-        file->writeShort(0xFFFF);
-        file->writeShort(0x00B8);
-        file->writeShort(0x0200);
-        file->writeShort(0x0002);
-        file->writeInt((curDir->parentDir != nullptr) ? curDir->parentDir->tempID : 0xFFFFFFFF);
-        file->writeInt(0x00000010);
-        file->writeInt(0x00000000);
-        fileSubOffset += 0x28;
-
-        /**
-         * determine who's next on the list
-         * if we have a child directory, process it
-         * otherwise, look if we have remaining siblings
-         * and if none, go back to our parent and look for siblings again
-         * until we have done them all
-        **/
-        if(!curDir->childrenDirs.empty())
-        {
-            dirStack.push(Iterator(&curDir->childrenDirs));
-            curDir = *(++(dirStack.top())); // TODO might crash, no idea
-        }
-        else
-        {
-            curDir = nullptr;
-            while(curDir == nullptr)
-            {
-                if(dirStack.empty())
-                    break;
-
-                auto& iterator = dirStack.top();
-                if(iterator.hasNext())
-                    curDir = *(++iterator);
-                else
-                    dirStack.pop();
-            }
+        writer.writeShort(0xFFFF);
+        writer.writeShort(0x002E);
+        writer.writeShort(0x0200);
+        writer.writeShort(0x0000);
+        writer.writeInt(dir->tempID);
+        writer.writeInt(0x00000010);
+        writer.writeInt(0x00000000);
+        writer.writeShort(0xFFFF);
+        writer.writeShort(0x00B8);
+        writer.writeShort(0x0200);
+        writer.writeShort(0x0002);
+        writer.writeInt((dir->parentDir != NONE) ? m_dirs[dir->parentDir].tempID : 0xFFFFFFFF);
+        writer.writeInt(0x00000010);
+        writer.writeInt(0x00000000);
+
+        entryIndex += dir->childrenDirs.size() + dir->childrenFiles.size() + 2;
+    }
 
-            if(curDir == nullptr)
-                break;
+    // everything's copied, point the entries at the new archive
+    fileIndex = 0;
+    for(DirEntry* dir : dirOrder)
+    {
+        for(uint32_t f : dir->childrenFiles)
+        {
+            m_files[f].dataOffset = dataOffset + fileDataOffsets[fileIndex++];
+            m_files[f].data.reset(); // release RAM
         }
     }
 
-    file->save();
+    // views opened before this still own the old buffer, so they don't notice the swap
+    file->setContents(std::move(out));
+    m_layoutChanged = false;
 }
 
 void RarcFile::close()
@@ -301,81 +496,134 @@ void RarcFile::close()
     file->close();
 }
 
-QStringList RarcFile::getSubDirectories(const QString& dirName)
+uint32_t RarcFile::getLength() const
 {
-    QStringList ret;
-    if(!directoryExists(dirName))
-        return ret;
+    return file->getLength();
+}
+
+void RarcFile::setDeduplicate(bool dedup)
+{
+    m_deduplicate = dedup;
+}
+
+RarcFile::DuplicateReport RarcFile::findDuplicates() const
+{
+    DuplicateReport ret;
+    std::unordered_set<std::string_view> seen;
+    seen.reserve(fileEntries.size());
+
+    for(const auto& [key, index] : fileEntries)
+    {
+        std::span<const uint8_t> bytes = fileBytes(m_files[index]);
+
+        ret.numFiles++;
+        ret.totalSize += bytes.size();
+
+        if(!seen.insert(std::string_view((const char*) bytes.data(), bytes.size())).second)
+        {
+            ret.numDuplicates++;
+            ret.duplicateSize += align32(bytes.size());
+        }
+    }
+
+    return ret;
+}
+
+RarcFile::NameList<RarcFile::DirEntry> RarcFile::subDirectories(QStringView dirName) const
+{
+    uint32_t dir = findDir(relativePath(dirName));
+    return (dir != NONE) ? NameList<DirEntry>(m_dirs[dir].childrenDirs, m_dirs) : NameList<DirEntry>();
+}
+
+RarcFile::NameList<RarcFile::DirEntry> RarcFile::subDirectories(std::string_view dirName) const
+{
+    uint32_t dir = findDir(relativePath(dirName));
+    return (dir != NONE) ? NameList<DirEntry>(m_dirs[dir].childrenDirs, m_dirs) : NameList<DirEntry>();
+}
+
+RarcFile::NameList<RarcFile::FileEntry> RarcFile::files(QStringView dirName) const
+{
+    uint32_t dir = findDir(relativePath(dirName));
+    return (dir != NONE) ? NameList<FileEntry>(m_dirs[dir].childrenFiles, m_files) : NameList<FileEntry>();
+}
 
-    DirEntry* dir = dirEntries[pathToKey(dirName)];
+RarcFile::NameList<RarcFile::FileEntry> RarcFile::files(std::string_view dirName) const
+{
+    uint32_t dir = findDir(relativePath(dirName));
+    return (dir != NONE) ? NameList<FileEntry>(m_dirs[dir].childrenFiles, m_files) : NameList<FileEntry>();
+}
 
-    for(auto dirEntry : dir->childrenDirs)
-        ret.push_back(dirEntry->name);
+QStringList RarcFile::getSubDirectories(const QString& dirName)
+{
+    QStringList ret;
+    for(const QString& name : subDirectories(dirName))
+        ret.push_back(name);
 
     return ret;
 }
 
-bool RarcFile::directoryExists(const std::string& dirName)
+bool RarcFile::directoryExists(QStringView dirName) const
 {
-    return directoryExists(QString::fromStdString(dirName));
+    return findDir(relativePath(dirName)) != NONE;
 }
 
-bool RarcFile::directoryExists(const QString& dirName)
+bool RarcFile::directoryExists(std::string_view dirName) const
 {
-    return dirEntries.find(pathToKey(dirName)) != dirEntries.end();
+    return findDir(relativePath(dirName)) != NONE;
 }
 
 void RarcFile::mkDir(const QString& parent, const QString& dirName)
 {
-    QString fullName = parent + '/' + dirName;
+    uint32_t parentDir = findDir(relativePath(parent));
 
     // do nothing if parent doesn't exist, or dir exists
-    if(!directoryExists(parent) || directoryExists(fullName))
+    if(parentDir == NONE)
+        return;
+
+    QString fullName = m_dirs[parentDir].fullName + '/' + dirName;
+    if(directoryExists(fullName))
         return;
 
-    DirEntry* parentDir = dirEntries[parent.toLower().toStdString()];
-    DirEntry* newDir = new DirEntry();
-    newDir->fullName = fullName;
-    newDir->name = dirName;
-    newDir->parentDir = parentDir;
-    parentDir->childrenDirs.push_back(newDir);
-    dirEntries.insert(std::make_pair(fullName.toLower().toStdString(), newDir));
+    uint32_t newDir = m_dirs.size();
+    m_dirs.push_back(DirEntry{ parentDir, dirName, fullName });
+    m_dirs[parentDir].childrenDirs.push_back(newDir);
+    dirEntries.insert(std::make_pair(pathToKey(fullName), newDir));
+
+    m_layoutChanged = true;
 }
 
 void RarcFile::mvDir(const QString& oldName, const QString& newName)
 {
-    if(!directoryExists(oldName))
+    uint32_t victimDir = findDir(relativePath(oldName));
+    if(victimDir == NONE)
         return;
 
-    DirEntry* victimDir = dirEntries[oldName.toLower().toStdString()];
-    DirEntry* parent = victimDir->parentDir;
-
-    QString newFullName = parent->fullName + '/' + newName;
+    uint32_t parent = m_dirs[victimDir].parentDir;
 
-    QString parentPath;
-    if(parent != nullptr)
+    QString newFullName = '/' + newName;
+    if(parent != NONE)
     {
+        newFullName = m_dirs[parent].fullName + newFullName;
+
         if(fileExists(newFullName) || directoryExists(newFullName))
             return;
-
-        parentPath = parent->fullName;
     }
 
-    dirEntries.erase(victimDir->fullName.toLower().toStdString());
-    victimDir->name = newName;
-    victimDir->fullName = newFullName;
-    dirEntries.insert(std::make_pair(victimDir->fullName.toLower().toStdString(), victimDir));
+    m_dirs[victimDir].name = newName;
+    rekeyDir(victimDir, newFullName);
+
+    m_layoutChanged = true;
 }
 
 void RarcFile::rmDir(const QString& dirName)
 {
-    if(!directoryExists(dirName))
+    uint32_t victimDir = findDir(relativePath(dirName));
+    if(victimDir == NONE)
         return;
 
-    DirEntry* victimDir = dirEntries[dirName.toLower().toStdString()];
-    DirEntry* parent = victimDir->parentDir;
+    uint32_t parent = m_dirs[victimDir].parentDir;
 
-    // TODO if(parent != nullptr)
+    // TODO if(parent != NONE)
         //parent->childrenDirs.erase(parent->childrenDirs[]);
 
 }
@@ -383,100 +631,95 @@ void RarcFile::rmDir(const QString& dirName)
 QStringList RarcFile::getFiles(const QString& dirName)
 {
     QStringList ret;
-    if(!directoryExists(QString::fromStdString(pathToKey(dirName))))
-        return ret;
-
-    DirEntry* dir = dirEntries[pathToKey(dirName)];
-
-    for(FileEntry* file : dir->childrenFiles)
-        ret.push_back(file->name);
+    for(const QString& name : files(dirName))
+        ret.push_back(name);
 
     return ret;
 }
 
-bool RarcFile::fileExists(const std::string& filePath)
+bool RarcFile::fileExists(QStringView filePath) const
 {
-    return fileExists(QString::fromStdString(filePath));
+    return findFile(relativePath(filePath)) != NONE;
 }
 
-
-bool RarcFile::fileExists(const QString& filePath)
+bool RarcFile::fileExists(std::string_view filePath) const
 {
-    return fileEntries.find(pathToKey(filePath)) != fileEntries.end();
+    return findFile(relativePath(filePath)) != NONE;
 }
 
 void RarcFile::mkFile(const QString& dirName, const QString& fileName)
 {
-    // TODO fix this mess of mixing std::string with QString
-    QString fullName = dirName + '/' + fileName;
-    std::string parentKey = pathToKey(dirName);
-    std::string fnKey = pathToKey(fullName);
-
-    if(!directoryExists(parentKey)
-            || fileExists(fnKey)
-            || directoryExists(fnKey))
+    uint32_t parentDir = findDir(relativePath(dirName));
+    if(parentDir == NONE)
         return;
 
-    DirEntry* parentDir = dirEntries[parentKey];
+    QString fullName = m_dirs[parentDir].fullName + '/' + fileName;
+    if(fileExists(fullName) || directoryExists(fullName))
+        return;
 
-    FileEntry* fileEntry = new FileEntry
+    uint32_t fileEntry = m_files.size();
+    m_files.push_back(FileEntry
     {
         parentDir,
         0, // dataOffset is not set in Whitehole??
         0, // dataSize starts at zero
+        0, // no entry until it's saved
         fileName,
         fullName,
-    };
+    });
 
-    parentDir->childrenFiles.push_back(fileEntry);
+    m_dirs[parentDir].childrenFiles.push_back(fileEntry);
     fileEntries.insert(std::make_pair(pathToKey(fullName), fileEntry));
+
+    m_layoutChanged = true;
 }
 
 void RarcFile::mvFile(const QString& oldPath, const QString& newPath)
 {
-    std::string oldFile = pathToKey(oldPath);
-    if(!fileExists(oldFile))
+    uint32_t index = findFile(relativePath(oldPath));
+    if(index == NONE)
         return;
 
-    FileEntry* fileEntry = fileEntries[oldFile];
-    DirEntry* parent= fileEntry->parentDir;
+    FileEntry* fileEntry = &m_files[index];
 
-    QString newFullName = parent->fullName + '/' + newPath;
-    std::string parentKey = pathToKey(newFullName);
-    if(fileExists(parentKey)
-        || directoryExists(parentKey))
+    QString newFullName = m_dirs[fileEntry->parentDir].fullName + '/' + newPath;
+    if(fileExists(newFullName) || directoryExists(newFullName))
         return; // TODO Whitehole says "temp" here. Why?
 
-    std::string fnKey = pathToKey(fileEntry->fullName);
-    fileEntries.erase(fnKey);
+    fileEntries.erase(pathToKey(fileEntry->fullName));
 
     fileEntry->name = newPath;
     fileEntry->fullName = newFullName;
 
-    fnKey = pathToKey(fileEntry->fullName);
-    fileEntries.insert(std::make_pair(fnKey, fileEntry));
+    fileEntries.insert(std::make_pair(pathToKey(newFullName), index));
+
+    m_layoutChanged = true;
 }
 
 void RarcFile::rmFile(const QString& filePath)
 {
-    std::string file = pathToKey(filePath);
-    if(!fileExists(file))
+    auto it = fileEntries.find(relativePath(filePath));
+    if(it == fileEntries.end())
         return;
 
-    FileEntry* fileEntry = fileEntries[file];
-    DirEntry* parent = fileEntry->parentDir;
+    uint32_t fileEntry = it->second;
+    DirEntry& parent = m_dirs[m_files[fileEntry].parentDir];
 
     // I wish this were easier in C++ :weary:
-    for(int i = 0; i < parent->childrenFiles.size(); i++)
+    for(int i = 0; i < parent.childrenFiles.size(); i++)
     {
-        if(parent->childrenFiles[i] == fileEntry)
+        if(parent.childrenFiles[i] == fileEntry)
         {
-            parent->childrenFiles.erase(parent->childrenFiles.begin() + i);
+            parent.childrenFiles.erase(parent.childrenFiles.begin() + i);
             break;
         }
     }
 
-    fileEntries.erase(file);
+    // its slot in m_files stays, nothing points at it any more
+    m_files[fileEntry].data.reset();
+    fileEntries.erase(it);
+
+    m_layoutChanged = true;
 }
 
 BaseFile* RarcFile::openFile(const QString& filePath)
@@ -489,34 +732,158 @@ BaseFile* RarcFile::openFile(const QString& filePath)
 
 std::vector<uint8_t> RarcFile::getFileContents(const QString& filePath)
 {
-    FileEntry* fileEntry = fileEntries[pathToKey(filePath)];
+    std::shared_ptr<const void> owner;
+    std::span<const uint8_t> bytes = getFileView(filePath, owner);
+
+    return std::vector<uint8_t>(bytes.begin(), bytes.end());
+}
+
+std::span<const uint8_t> RarcFile::getFileView(const QString& filePath, std::shared_ptr<const void>& owner)
+{
+    uint32_t index = findFile(relativePath(filePath));
+    assert(index != NONE); // no such file
+
+    const FileEntry& fileEntry = m_files[index];
+
+    // the archive copies itself before its next write, so the slice stays as it is for whoever holds owner
+    if(fileEntry.data != nullptr)
+        owner = fileEntry.data;
+    else
+        owner = file->shareContents();
 
-    if(!fileEntry->data.empty())
-        return fileEntry->data;
+    return fileBytes(fileEntry);
+}
+
+std::span<const uint8_t> RarcFile::fileBytes(const FileEntry& fileEntry) const
+{
+    if(fileEntry.data != nullptr)
+        return *fileEntry.data;
 
-    file->position(fileEntry->dataOffset);
-    return file->readBytes(fileEntry->dataSize); // TODO should we set fileEntry->data?
+    return file->slice(fileEntry.dataOffset, fileEntry.dataOffset + fileEntry.dataSize);
 }
 
 void RarcFile::reinsertFile(const InRarcFile& file)
 {
-    FileEntry* fileEntry = fileEntries[pathToKey(file.m_fullName)];
-    fileEntry->data = file.getContents();
+    FileEntry* fileEntry = &m_files[findFile(relativePath(file.m_fullName))];
+    std::span<const uint8_t> contents = file.getContents();
+    fileEntry->data = std::make_shared<const std::vector<uint8_t>>(contents.begin(), contents.end());
     fileEntry->dataSize = file.getLength(); // TODO maybe unnecessary, could use data length directly
 }
 
 
-std::string RarcFile::pathToKey(const QString& path)
+RarcFile::PathRef RarcFile::relativePath(QStringView path)
+{
+    const char16_t* chars = (const char16_t*) path.data();
+    uint32_t start = rootEnd(chars, path.size());
+
+    if(start == 0)
+        return PathRef{ ROOT_PATH, 1, true };
+
+    return PathRef{ chars + start, uint32_t(path.size() - start), true };
+}
+
+RarcFile::PathRef RarcFile::relativePath(std::string_view path)
+{
+    uint32_t start = rootEnd(path.data(), path.size());
+
+    if(start == 0)
+        return PathRef{ ROOT_PATH, 1, true };
+
+    return PathRef{ path.data() + start, uint32_t(path.size() - start), false };
+}
+
+std::u16string RarcFile::pathToKey(QStringView path)
 {
-    std::string ret = path.toLower().toStdString();
-    ret = ret.substr(1);
-    if (ret.find("/") == std::string::npos)
-        return "/";
+    PathRef relative = relativePath(path);
+
+    std::u16string ret(relative.length, u'\0');
+    for(uint32_t i = 0; i < relative.length; i++)
+        ret[i] = foldCase(relative[i]);
 
-    ret = ret.substr(ret.find("/"));
     return ret;
 }
 
+size_t RarcFile::PathHash::operator()(PathRef path) const
+{
+    // FNV-1a over the folded chars
+    uint64_t hash = 0xCBF29CE484222325;
+    for(uint32_t i = 0; i < path.length; i++)
+    {
+        hash ^= foldCase(path[i]);
+        hash *= 0x100000001B3;
+    }
+
+    return hash;
+}
+
+size_t RarcFile::PathHash::operator()(const std::u16string& key) const
+{
+    return (*this)(PathRef{ key.data(), uint32_t(key.size()), true });
+}
+
+bool RarcFile::PathEqual::operator()(PathRef a, PathRef b) const
+{
+    if(a.length != b.length)
+        return false;
+
+    for(uint32_t i = 0; i < a.length; i++)
+    {
+        if(foldCase(a[i]) != foldCase(b[i]))
+            return false;
+    }
+
+    return true;
+}
+
+bool RarcFile::PathEqual::operator()(PathRef a, const std::u16string& b) const
+{
+    return (*this)(a, PathRef{ b.data(), uint32_t(b.size()), true });
+}
+
+bool RarcFile::PathEqual::operator()(const std::u16string& a, PathRef b) const
+{
+    return (*this)(PathRef{ a.data(), uint32_t(a.size()), true }, b);
+}
+
+bool RarcFile::PathEqual::operator()(const std::u16string& a, const std::u16string& b) const
+{
+    return a == b; // keys are already folded
+}
+
+uint32_t RarcFile::findDir(PathRef path) const
+{
+    auto it = dirEntries.find(path);
+    return (it != dirEntries.end()) ? it->second : NONE;
+}
+
+uint32_t RarcFile::findFile(PathRef path) const
+{
+    auto it = fileEntries.find(path);
+    return (it != fileEntries.end()) ? it->second : NONE;
+}
+
+void RarcFile::rekeyDir(uint32_t dir, const QString& fullName)
+{
+    DirEntry& dirEntry = m_dirs[dir];
+
+    // the old keys come from the old names, so drop each one before renaming
+    dirEntries.erase(pathToKey(dirEntry.fullName));
+    dirEntry.fullName = fullName;
+    dirEntries.insert(std::make_pair(pathToKey(fullName), dir));
+
+    for(uint32_t f : dirEntry.childrenFiles)
+    {
+        FileEntry& fileEntry = m_files[f];
+
+        fileEntries.erase(pathToKey(fileEntry.fullName));
+        fileEntry.fullName = fullName + '/' + fileEntry.name;
+        fileEntries.insert(std::make_pair(pathToKey(fileEntry.fullName), f));
+    }
+
+    for(uint32_t child : dirEntry.childrenDirs)
+        rekeyDir(child, fullName + '/' + m_dirs[child].name);
+}
+
 uint32_t RarcFile::align32(uint32_t val) {
     return (val + 0x1F) & ~0x1F;
 }
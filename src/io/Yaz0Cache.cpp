@@ -0,0 +1,185 @@
+#include "io/Yaz0Cache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <bit>
+#include <cstring>
+
+namespace
+{
+    // every entry starts with this, followed by the data
+    struct EntryHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceSize;
+        int64_t sourceModified;
+        uint64_t contentHash;
+        uint64_t dataSize;
+        uint8_t padding[24]; // so the data starts 64 bytes in
+    };
+
+    static_assert(sizeof(EntryHeader) == 64);
+
+    constexpr char ENTRY_MAGIC[4] = { 'B', 'H', 'Y', 'C' };
+    constexpr uint32_t ENTRY_VERSION = 1;
+
+    // not cryptographic, just quick and well mixed. takes 8 bytes at a time
+    uint64_t hashBytes(std::span<const uint8_t> bytes)
+    {
+        constexpr uint64_t K1 = 0x9E3779B97F4A7C15;
+        constexpr uint64_t K2 = 0xBF58476D1CE4E5B9;
+
+        uint64_t h = bytes.size() * K1;
+
+        size_t i = 0;
+        for(; i + 8 <= bytes.size(); i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, bytes.data() + i, 8);
+            h = std::rotl(h ^ (word * K1), 29) * K2;
+        }
+
+        if(i < bytes.size())
+        {
+            uint64_t word = 0;
+            memcpy(&word, bytes.data() + i, bytes.size() - i);
+            h = std::rotl(h ^ (word * K1), 29) * K2;
+        }
+
+        h ^= h >> 31;
+        h *= K1;
+        h ^= h >> 29;
+        return h;
+    }
+}
+
+QString Yaz0Cache::m_directory;
+qint64 Yaz0Cache::m_sizeLimit = 512 * 1024 * 1024;
+std::mutex Yaz0Cache::m_lock;
+
+void Yaz0Cache::setDirectory(const QString& directory)
+{
+    m_directory = directory;
+
+    if(!m_directory.isEmpty())
+        QDir().mkpath(m_directory);
+}
+
+QString Yaz0Cache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/archives";
+}
+
+bool Yaz0Cache::isEnabled()
+{
+    return !m_directory.isEmpty();
+}
+
+void Yaz0Cache::setSizeLimit(qint64 bytes)
+{
+    m_sizeLimit = bytes;
+}
+
+Yaz0Cache::Key Yaz0Cache::makeKey(const QString& sourcePath, std::span<const uint8_t> compressed)
+{
+    QFileInfo info(sourcePath);
+
+    Key ret;
+    ret.sourcePath = info.absoluteFilePath();
+    ret.size = compressed.size();
+    ret.modified = info.lastModified().toMSecsSinceEpoch();
+    ret.contentHash = hashBytes(compressed);
+
+    return ret;
+}
+
+QString Yaz0Cache::entryPath(const QString& sourcePath)
+{
+    // one entry per source file, a newer version just replaces it
+    QByteArray pathBytes = sourcePath.toUtf8();
+    uint64_t pathHash = hashBytes(std::span((const uint8_t*) pathBytes.constData(), pathBytes.size()));
+
+    return m_directory + '/' + QString::number(pathHash, 16).rightJustified(16, '0') + ".bin";
+}
+
+bool Yaz0Cache::find(const Key& key, std::span<const uint8_t>& data, std::shared_ptr<const void>& owner)
+{
+    if(!isEnabled())
+        return false;
+
+    // same as ExternalFile, the QFile owns the mapping
+    auto file = std::make_shared<QFile>(entryPath(key.sourcePath));
+    if(!file->open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 size = file->size();
+    uchar* mapped = (size >= qint64(sizeof(EntryHeader))) ? file->map(0, size) : nullptr;
+
+    // recently used entries are the last to be evicted
+    file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    file->close();
+
+    if(mapped == nullptr)
+        return false;
+
+    EntryHeader header;
+    memcpy(&header, mapped, sizeof(header));
+
+    if(memcmp(header.magic, ENTRY_MAGIC, 4) != 0 || header.version != ENTRY_VERSION ||
+            header.sourceSize != key.size || header.sourceModified != key.modified ||
+            header.contentHash != key.contentHash || header.dataSize != uint64_t(size) - sizeof(header))
+        return false;
+
+    data = std::span<const uint8_t>(mapped + sizeof(header), header.dataSize);
+    owner = file;
+    return true;
+}
+
+void Yaz0Cache::store(const Key& key, std::span<const uint8_t> data)
+{
+    if(!isEnabled())
+        return;
+
+    EntryHeader header = {};
+    memcpy(header.magic, ENTRY_MAGIC, 4);
+    header.version = ENTRY_VERSION;
+    header.sourceSize = key.size;
+    header.sourceModified = key.modified;
+    header.contentHash = key.contentHash;
+    header.dataSize = data.size();
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    // written next to the old entry and swapped in, so anyone still mapping that one is fine
+    QSaveFile file(entryPath(key.sourcePath));
+    if(!file.open(QIODevice::WriteOnly))
+        return;
+
+    file.write((const char*) &header, sizeof(header));
+    file.write((const char*) data.data(), data.size());
+
+    if(file.commit())
+        evict();
+}
+
+void Yaz0Cache::evict()
+{
+    // newest first, so everything past the limit is the least recently used
+    QDir dir(m_directory);
+    QFileInfoList entries = dir.entryInfoList(QStringList() << "*.bin", QDir::Files, QDir::Time);
+
+    qint64 total = 0;
+    for(const QFileInfo& entry : entries)
+    {
+        total += entry.size();
+
+        if(total > m_sizeLimit)
+            QFile::remove(entry.absoluteFilePath());
+    }
+}
@@ -0,0 +1,154 @@
+#include "io/Yaz0Decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // copies length bytes from dist bytes back. when the two overlap the output repeats every
+    // dist bytes, so copying from any multiple of dist back gives the same bytes, and once
+    // that's 8 or more the copy can go 8 bytes at a time. bufEnd is how far we may scribble
+    inline void copyMatch(uint8_t* dst, uint32_t dist, uint32_t length, const uint8_t* bufEnd)
+    {
+        if(dist == 1)
+        {
+            memset(dst, dst[-1], length);
+            return;
+        }
+
+        uint32_t i = 0;
+        const uint8_t* src = dst - dist;
+
+        if(dist < 8)
+        {
+            uint32_t period = dist * ((8 + dist - 1) / dist);
+            for(; i < period && i < length; i++)
+                dst[i] = src[i];
+
+            src = dst - period;
+        }
+
+        // the last chunk may write up to 7 bytes too many, later output overwrites them
+        if(uint32_t(bufEnd - dst) >= length + 7)
+        {
+            for(; i < length; i += 8)
+                memcpy(dst + i, src + i, 8);
+
+            return;
+        }
+
+        for(; i + 8 <= length; i += 8)
+            memcpy(dst + i, src + i, 8);
+
+        for(; i < length; i++)
+            dst[i] = src[i];
+    }
+}
+
+Yaz0Decoder::Yaz0Decoder(std::span<const uint8_t> in, std::span<uint8_t> out)
+        : m_in(in), m_out(out)
+{
+    m_failed = in.size() < 16;
+}
+
+bool Yaz0Decoder::decodeUpTo(uint32_t end)
+{
+    if(m_failed)
+        return false;
+
+    const uint8_t* in = m_in.data() + m_inPos;
+    const uint8_t* inEnd = m_in.data() + m_in.size();
+
+    uint8_t* dst = m_out.data() + m_outPos;
+    uint8_t* dstEnd = m_out.data() + m_out.size();
+    uint8_t* target = m_out.data() + std::min<size_t>(end, m_out.size());
+
+    uint8_t block = m_block;
+    uint32_t blockLeft = m_blockLeft;
+
+    while(dst < target)
+    {
+        if(blockLeft == 0)
+        {
+            if(in == inEnd)
+            {
+                m_failed = true;
+                break;
+            }
+
+            block = *in++;
+
+            // eight plain bytes in a row is common enough in poorly compressible data to be worth a shortcut
+            if(block == 0xFF && inEnd - in >= 8 && dstEnd - dst >= 8)
+            {
+                memcpy(dst, in, 8);
+                in += 8;
+                dst += 8;
+                continue;
+            }
+
+            blockLeft = 8;
+        }
+
+        bool plain = (block & 0x80) != 0;
+        block <<= 1;
+        blockLeft--;
+
+        if(plain) // copy one plain byte
+        {
+            if(in == inEnd)
+            {
+                m_failed = true;
+                break;
+            }
+
+            *dst++ = *in++;
+            continue;
+        }
+
+        // copy N compressed bytes
+        if(inEnd - in < 2)
+        {
+            m_failed = true;
+            break;
+        }
+
+        uint32_t dist = (((in[0] & 0x0F) << 8) | in[1]) + 1;
+        uint32_t length = in[0] >> 4;
+
+        if(length == 0)
+        {
+            if(inEnd - in < 3)
+            {
+                m_failed = true;
+                break;
+            }
+
+            length = in[2] + 0x12;
+            in++;
+        }
+        else
+            length += 2;
+
+        in += 2;
+
+        if(dist > dst - m_out.data())
+        {
+            m_failed = true;
+            break;
+        }
+
+        // some encoders let the last copy run past the end, just cut it short
+        length = std::min<uint32_t>(length, dstEnd - dst);
+
+        copyMatch(dst, dist, length, dstEnd);
+        dst += length;
+    }
+
+    m_inPos = in - m_in.data();
+    m_outPos = dst - m_out.data();
+    m_block = block;
+    m_blockLeft = blockLeft;
+
+    return !m_failed;
+}
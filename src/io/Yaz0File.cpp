@@ -1,183 +1,565 @@
 #include "io/Yaz0File.h"
 
+#include "io/ByteSwap.h"
+#include "io/Yaz0Cache.h"
+#include "io/Yaz0Decoder.h"
 #include "io/ExternalFile.h"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
-Yaz0File::Yaz0File(QString filePath)
-        : MemoryFile(), m_backend(ExternalFile(filePath))
+namespace
 {
-    m_contents = decompress(m_backend.getContents());
-}
-
-void Yaz0File::save()
-{
-    std::vector<uint8_t> compressedBytes = compress(m_contents);
+    struct Match
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0; // 0 means no match
+    };
 
-    m_backend.setContents(compressedBytes);
-    m_backend.save();
-    // TODO release storage here maybe
-}
+    constexpr uint32_t WINDOW_SIZE = 0x1000;
+    constexpr uint32_t MIN_MATCH = 3;
+    constexpr uint32_t MAX_MATCH = 0x111;
 
-std::vector<uint8_t> Yaz0File::decompress(const std::vector<uint8_t>& data)
-{
-    if(!(data[0] == 'Y' && data[1] == 'a' && data[2] == 'z' && data[3] == '0'))
-        return data; // TODO error message?
+    // inputs bigger than this get compressed in segments of SEGMENT_SIZE, on every core
+    constexpr uint32_t SEGMENT_SIZE = 0x40000;
+    constexpr uint32_t PARALLEL_THRESHOLD = 2 * SEGMENT_SIZE;
 
-    uint32_t fullSize = ((data[4] & 0xFF) << 24) | ((data[5] & 0xFF) << 16) | ((data[6] & 0xFF) << 8) | (data[7] & 0xFF);
-    std::vector<uint8_t> ret(fullSize);
+    // how many earlier positions with the same prefix we try before settling.
+    // the optimal parse can afford to look at the whole window
+    constexpr uint32_t FAST_CHAIN = 256;
+    constexpr uint32_t FULL_CHAIN = WINDOW_SIZE;
 
-    int inPos = 16, outPos = 0;
-    while(outPos < fullSize)
+    // compares up to maxLength bytes, 8 at a time
+    uint32_t matchLength(const uint8_t* a, const uint8_t* b, uint32_t maxLength)
     {
-        uint8_t block = data[inPos++];
+        uint32_t len = 0;
 
-        for(int i = 0; i < 8; i++)
+        while(len + 8 <= maxLength)
         {
-            if((block & 0x80) != 0) // copy one plain byte
+            uint64_t x, y;
+            memcpy(&x, a + len, 8);
+            memcpy(&y, b + len, 8);
+
+            if(x != y)
             {
-                ret[outPos++] = data[inPos++];
+                uint64_t diff = x ^ y;
+                return len + (ByteSwap::NATIVE_BIG ? std::countl_zero(diff) : std::countr_zero(diff)) / 8;
             }
-            else
-            {
-                // copy N compressed bytes
-                uint8_t b1 = data[inPos++];
-                uint8_t b2 = data[inPos++];
 
-                uint16_t dist = ((b1 & 0x0F) << 8) | (b2 & 0xFF);
-                uint32_t copySrc = outPos - (dist + 1);
+            len += 8;
+        }
 
-                uint32_t nbytes = (b1 & 0xFF) >> 4;
+        while(len < maxLength && a[len] == b[len])
+            len++;
 
-                if(nbytes == 0)
-                    nbytes = (data[inPos++] & 0xFF) + 0x12;
-                else
-                    nbytes += 2;
+        return len;
+    }
 
-                for(int j = 0; j < nbytes; j++)
-                    ret[outPos++] = ret[copySrc++];
-            }
+    // hash chains over 3-byte prefixes: head holds the latest position for each hash,
+    // prev links every position in the window to the previous one with the same hash.
+    // positions are inserted lazily up to the one being searched, so lookups must not go backwards
+    class MatchFinder
+    {
+        static constexpr uint32_t HASH_BITS = 15;
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        std::span<const uint8_t> m_data;
+        std::vector<uint32_t> m_head;
+        std::vector<uint32_t> m_prev;
+        uint32_t m_inserted = 0;
+        uint32_t m_maxChain;
 
-            block <<= 1;
-            if(outPos >= fullSize || inPos >= data.size())
-                break;
+        uint32_t hash(uint32_t pos) const
+        {
+            uint32_t prefix = (m_data[pos] << 16) | (m_data[pos + 1] << 8) | m_data[pos + 2];
+            return (prefix * 2654435761u) >> (32 - HASH_BITS);
         }
-    }
 
-    return ret;
-}
+        void insertUpTo(uint32_t pos)
+        {
+            for(; m_inserted < pos; m_inserted++)
+            {
+                uint32_t h = hash(m_inserted);
+                m_prev[m_inserted % WINDOW_SIZE] = m_head[h];
+                m_head[h] = m_inserted;
+            }
+        }
 
-std::vector<uint8_t> Yaz0File::compress(const std::vector<uint8_t>& data)
-{
-    size_t compressedSize = 16 + data.size() + (data.size() / 8);
+    public:
+        MatchFinder(std::span<const uint8_t> data, uint32_t maxChain)
+                : m_data(data), m_head(1 << HASH_BITS, NONE), m_prev(WINDOW_SIZE, NONE), m_maxChain(maxChain) {}
 
-    std::vector<uint8_t> ret(compressedSize);
+        // longest match for pos in the window, or length 0 if there's none worth encoding
+        Match find(uint32_t pos)
+        {
+            if(pos + MIN_MATCH > m_data.size())
+                return Match();
 
-    ret[0] = 'Y'; ret[1] = 'a'; ret[2] = 'z'; ret[3] = '0';
+            insertUpTo(pos);
 
-    uint32_t fullSize = data.size();
-    ret[4] = (fullSize >> 24) & 0xFF;
-    ret[5] = (fullSize >> 16) & 0xFF;
-    ret[6] = (fullSize >> 8 ) & 0xFF;
-    ret[7] = (fullSize      ) & 0xFF;
+            uint32_t maxLength = std::min<uint32_t>(MAX_MATCH, m_data.size() - pos);
+            uint32_t windowStart = pos > WINDOW_SIZE ? pos - WINDOW_SIZE : 0;
+            const uint8_t* cur = m_data.data() + pos;
 
-    int inPos = 0, outPos = 0;
-    Occurrence occ;
+            Match ret;
+            uint32_t candidate = m_head[hash(pos)];
 
-    while(inPos < fullSize)
+            for(uint32_t chain = 0; chain < m_maxChain && candidate != NONE && candidate >= windowStart; chain++)
+            {
+                const uint8_t* prev = m_data.data() + candidate;
+
+                // a candidate has to beat the best so far, so check the byte that would decide that first
+                if(prev[ret.length] == cur[ret.length])
+                {
+                    uint32_t len = matchLength(prev, cur, maxLength);
+                    if(len > ret.length)
+                    {
+                        ret.offset = candidate;
+                        ret.length = len;
+
+                        if(len == maxLength)
+                            break;
+                    }
+                }
+
+                candidate = m_prev[candidate % WINDOW_SIZE];
+            }
+
+            if(ret.length < MIN_MATCH)
+                return Match();
+
+            return ret;
+        }
+    };
+
+    // packs literals and back-references into groups of eight, each behind a flag byte
+    class TokenWriter
     {
-        uint32_t dataStart = outPos + 1;
-        uint8_t block = 0;
+        std::vector<uint8_t>& m_out;
+        size_t m_flagPos = 0;
+        uint32_t m_count = 8;
+
+        void nextToken(bool literal)
+        {
+            if(m_count == 8)
+            {
+                m_flagPos = m_out.size();
+                m_out.push_back(0);
+                m_count = 0;
+            }
 
-        for(int i = 0; i < 8; i++)
+            if(literal)
+                m_out[m_flagPos] |= 0x80 >> m_count;
+
+            m_count++;
+        }
+
+    public:
+        TokenWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+        void literal(uint8_t val)
+        {
+            nextToken(true);
+            m_out.push_back(val);
+        }
+
+        // dist is how far back the copy starts, 1 being the previous byte
+        void match(uint32_t dist, uint32_t length)
         {
-            block <<= 1;
+            uint32_t disp = dist - 1;
+            assert(disp < WINDOW_SIZE && length >= MIN_MATCH && length <= MAX_MATCH);
 
-            if(inPos < data.size())
+            nextToken(false);
+
+            if(length > 17)
+            {
+                m_out.push_back((disp >> 8) & 0xFF);
+                m_out.push_back(disp & 0xFF);
+                m_out.push_back((length - 18) & 0xFF);
+            }
+            else
             {
-                if(occ.offset == -2) // TODO -2?
-                    occ = findOccurrence(data, inPos);
+                m_out.push_back((((length - 2) << 4) | (disp >> 8)) & 0xFF);
+                m_out.push_back(disp & 0xFF);
+            }
+        }
+    };
 
-                Occurrence next = findOccurrence(data, inPos + 1);
-                if(next.length > occ.length + 1)
-                    occ.offset = -1;
+    // the same tokens, just recorded, so a worker thread can parse a segment
+    // and the groups get packed in order afterwards
+    class TokenList
+    {
+        struct Token
+        {
+            uint16_t dist;
+            uint16_t length; // 0 for a literal
+        };
 
-                if(occ.offset != -1)
-                {
-                    uint32_t disp = (inPos - occ.offset) - 1;
-                    assert(disp <= 4095); // TODO throw RuntimeException DISP OUT OF RANGE!
+        std::vector<Token> m_tokens;
 
-                    if(occ.length > 17)
-                    {
-                        if(occ.length > 273) occ.length = 273; // TODO use clamp
+    public:
+        void literal(uint8_t)
+        {
+            m_tokens.push_back({ 0, 0 });
+        }
 
-                        ret[dataStart++] = (disp >> 8)         & 0xFF;
-                        ret[dataStart++] = disp                & 0xFF;
-                        ret[dataStart++] = (occ.length - 18) & 0xFF;
-                    }
-                    else
-                    {
-                        ret[dataStart++] = (((occ.length - 2) << 4) | (disp >> 8)) & 0xFF;
-                        ret[dataStart++] = disp & 0xFF;
-                    }
+        void match(uint32_t dist, uint32_t length)
+        {
+            m_tokens.push_back({ uint16_t(dist), uint16_t(length) });
+        }
 
-                    inPos += occ.length;
-                    occ.offset = -2;
+        // data starts at the first byte the tokens cover
+        void replay(std::span<const uint8_t> data, TokenWriter& writer) const
+        {
+            uint32_t pos = 0;
+
+            for(const Token& token : m_tokens)
+            {
+                if(token.length == 0)
+                {
+                    writer.literal(data[pos++]);
                 }
                 else
                 {
-                    ret[dataStart++] = data[inPos++];
-                    block |= 0x01;
+                    writer.match(token.dist, token.length);
+                    pos += token.length;
                 }
+            }
+        }
+    };
+
+    // every byte a literal: 0xFF followed by eight bytes, over and over
+    void compressStore(std::span<const uint8_t> data, std::vector<uint8_t>& out)
+    {
+        size_t pos = out.size();
+        out.resize(pos + data.size() + (data.size() + 7) / 8);
+
+        for(size_t inPos = 0; inPos < data.size(); inPos += 8)
+        {
+            size_t count = std::min<size_t>(8, data.size() - inPos);
+
+            out[pos++] = 0xFF << (8 - count);
+            memcpy(out.data() + pos, data.data() + inPos, count);
+            pos += count;
+        }
+    }
+
+    // the parsers encode data from start on. bytes before start are only there to match against
+
+    // greedy, except that a literal goes first when the next position has a clearly better match
+    template<typename Writer>
+    void compressFast(std::span<const uint8_t> data, uint32_t start, Writer& writer)
+    {
+        MatchFinder finder(data, FAST_CHAIN);
+
+        uint32_t inPos = start;
+        Match occ = finder.find(start);
+
+        while(inPos < data.size())
+        {
+            // the lookahead becomes the next match, so every position is searched once
+            Match next = finder.find(inPos + 1);
+
+            if(occ.length != 0 && next.length <= occ.length + 1)
+            {
+                writer.match(inPos - occ.offset, occ.length);
+
+                inPos += occ.length;
+                occ = finder.find(inPos);
+            }
+            else
+            {
+                writer.literal(data[inPos++]);
+                occ = next;
+            }
+        }
+    }
+
+    // shortest output for the matches we can find. a literal costs 9 bits (byte + flag),
+    // a match 17 or 25 bits depending on its length, and any prefix of a match is a match
+    // too, so the longest match at each position is all the parse needs to know about
+    template<typename Writer>
+    void compressOptimal(std::span<const uint8_t> data, uint32_t start, Writer& writer)
+    {
+        // everything below is indexed from start
+        uint32_t size = data.size() - start;
 
-                if(occ.offset != -2)
+        std::vector<Match> matches(size);
+        MatchFinder finder(data, FULL_CHAIN);
+        for(uint32_t i = 0; i < size; i++)
+            matches[i] = finder.find(start + i);
+
+        // cost[i] is the fewest bits needed to encode everything from i on, and
+        // step[i] how many bytes the first token of that encoding covers (1 = literal)
+        std::vector<uint32_t> cost(size + 1);
+        std::vector<uint16_t> step(size);
+        cost[size] = 0;
+
+        for(uint32_t i = size; i-- > 0; )
+        {
+            uint32_t best = cost[i + 1] + 9;
+            uint32_t bestStep = 1;
+
+            for(uint32_t len = MIN_MATCH; len <= matches[i].length; len++)
+            {
+                uint32_t c = cost[i + len] + (len > 17 ? 25 : 17);
+                if(c < best)
                 {
-                    occ = next;
+                    best = c;
+                    bestStep = len;
                 }
             }
+
+            cost[i] = best;
+            step[i] = bestStep;
         }
 
-        ret[outPos] = block;
-        outPos = dataStart;
+        for(uint32_t i = 0; i < size; i += step[i])
+        {
+            if(step[i] == 1)
+                writer.literal(data[start + i]);
+            else
+                writer.match(start + i - matches[i].offset, step[i]);
+        }
     }
 
-    return ret;
-}
+    template<typename Writer>
+    void compressRange(std::span<const uint8_t> data, uint32_t start, Yaz0File::Level level, Writer& writer)
+    {
+        if(level == Yaz0File::Level::Optimal)
+            compressOptimal(data, start, writer);
+        else
+            compressFast(data, start, writer);
+    }
 
-Yaz0File::Occurrence Yaz0File::findOccurrence(const std::vector<uint8_t>& data, uint32_t pos)
-{
-    Occurrence ret;
+    // back-references never reach further than the window, so the input can be cut into fixed
+    // segments that are parsed on their own, each one seeing the window before it. the cuts only
+    // depend on the input size, so the output is the same however many threads there are
+    void compressSegments(std::span<const uint8_t> data, Yaz0File::Level level, TokenWriter& writer)
+    {
+        uint32_t numSegments = (data.size() + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+        std::vector<TokenList> segments(numSegments);
+        std::atomic<uint32_t> nextSegment = 0;
+
+        auto worker = [&]
+        {
+            for(uint32_t i = nextSegment++; i < numSegments; i = nextSegment++)
+            {
+                uint32_t start = i * SEGMENT_SIZE;
+                uint32_t end = std::min<uint32_t>(start + SEGMENT_SIZE, data.size());
+                uint32_t windowStart = start > WINDOW_SIZE ? start - WINDOW_SIZE : 0;
+
+                compressRange(data.subspan(windowStart, end - windowStart), start - windowStart, level, segments[i]);
+            }
+        };
+
+        uint32_t numThreads = std::min(std::max(std::thread::hardware_concurrency(), 1u), numSegments);
 
-    if (pos >= data.size() - 2)
-        return ret;
+        std::vector<std::future<void>> futures;
+        for(uint32_t i = 1; i < numThreads; i++)
+            futures.push_back(std::async(std::launch::async, worker));
 
-    std::vector<Occurrence> occurrences;
+        worker();
 
-    uint32_t len;
-    uint32_t start = (pos > 4096) ? pos - 4096 : 0;
-    for (int32_t i = start; i < pos; i++)
+        for(auto& future : futures)
+            future.get();
+
+        for(uint32_t i = 0; i < numSegments; i++)
+            segments[i].replay(data.subspan(i * SEGMENT_SIZE), writer);
+    }
+}
+
+Yaz0File::Level Yaz0File::m_defaultLevel = Yaz0File::Level::Fast;
+
+Yaz0File::Yaz0File(QString filePath)
+        : MemoryFile(), m_backend(ExternalFile(filePath)), m_level(m_defaultLevel)
+{
+    std::span<const uint8_t> data = m_backend.getContents();
+    if(!isCompressed(data))
     {
-        if (i >= data.size() - 2)
-            break;
+        setContents(std::vector<uint8_t>(data.begin(), data.end()));
+        markSaved(); // it's what's on disk
+        return;
+    }
 
-        if (data[i] != data[pos] || data[i + 1] != data[pos + 1] || data[i + 2] != data[pos + 2])
-            continue;
+    uint32_t size = decompressedSize(data);
 
-        len = 3;
-        while ((i + len < data.size()) && (pos + len < data.size()) && (data[i + len] == data[pos + len]))
-            len++;
+    if(Yaz0Cache::isEnabled())
+    {
+        // a copy decompressed by an earlier run just gets mapped
+        Yaz0Cache::Key key = Yaz0Cache::makeKey(filePath, data);
+
+        std::span<const uint8_t> cached;
+        std::shared_ptr<const void> owner;
+        if(Yaz0Cache::find(key, cached, owner) && cached.size() == size)
+        {
+            borrow(cached, owner);
+            return;
+        }
 
-        occurrences.emplace_back(Occurrence{i, len});
+        // otherwise it goes in the cache once it's been decoded all the way
+        m_cacheKey = std::move(key);
     }
 
-    for (Occurrence occ : occurrences)
+    // the buffer isn't zeroed, the decoder overwrites all of it
+    std::shared_ptr<uint8_t[]> buffer = std::make_shared_for_overwrite<uint8_t[]>(size);
+    std::span<uint8_t> decoded(buffer.get(), size);
+
+    // nothing gets decoded yet, reads pull in as much as they need
+    borrow(decoded, buffer);
+    m_decoder = std::make_unique<Yaz0Decoder>(data, decoded);
+    m_decoded = 0;
+}
+
+void Yaz0File::ensureLoaded(uint32_t end) const
+{
+    if(end <= m_decoded.load(std::memory_order_acquire))
+        return;
+
+    std::optional<Yaz0Cache::Key> cacheKey;
+
     {
-        if (occ.length > ret.length)
+        std::lock_guard<std::mutex> lock(m_decodeLock);
+        if(m_decoder == nullptr)
+            return;
+
+        if(!m_decoder->decodeUpTo(end))
+        {
+            // the decoder stays failed, so every later read past what it got through ends up here too
+            m_decoded.store(m_decoder->decoded(), std::memory_order_release);
+            throw std::runtime_error("Yaz0: corrupt data");
+        }
+
+        if(!m_decoder->done())
         {
-            ret.offset = occ.offset;
-            ret.length = occ.length;
+            m_decoded.store(m_decoder->decoded(), std::memory_order_release);
+            return;
         }
+
+        m_decoder.reset();
+        m_decoded.store(UINT32_MAX, std::memory_order_release);
+
+        cacheKey.swap(m_cacheKey);
     }
 
+    // it's all there now. written outside the lock, so reads don't wait on the disk
+    if(cacheKey)
+        Yaz0Cache::store(*cacheKey, m_view);
+}
+
+void Yaz0File::setContents(const std::vector<uint8_t>& bytes)
+{
+    stopDecoding();
+    MemoryFile::setContents(bytes);
+}
+
+void Yaz0File::setContents(std::vector<uint8_t>&& bytes)
+{
+    stopDecoding();
+    MemoryFile::setContents(std::move(bytes));
+}
+
+void Yaz0File::stopDecoding()
+{
+    std::lock_guard<std::mutex> lock(m_decodeLock);
+
+    m_decoder.reset();
+    m_decoded = UINT32_MAX;
+    m_cacheKey.reset(); // what's left isn't the archive's contents any more
+}
+
+void Yaz0File::setDefaultLevel(Level level)
+{
+    m_defaultLevel = level;
+}
+
+void Yaz0File::save()
+{
+    std::vector<uint8_t> compressedBytes = compress(getContents(), m_level);
+
+    m_backend.setContents(compressedBytes);
+    m_backend.save();
+    markSaved();
+    // TODO release storage here maybe
+}
+
+bool Yaz0File::isCompressed(std::span<const uint8_t> data)
+{
+    return data.size() >= 16 && data[0] == 'Y' && data[1] == 'a' && data[2] == 'z' && data[3] == '0';
+}
+
+uint32_t Yaz0File::decompressedSize(std::span<const uint8_t> data)
+{
+    if(!isCompressed(data))
+        return data.size();
+
+    return (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+}
+
+std::vector<uint8_t> Yaz0File::decompress(std::span<const uint8_t> data)
+{
+    if(!isCompressed(data))
+        return std::vector<uint8_t>(data.begin(), data.end());
+
+    std::vector<uint8_t> ret(decompressedSize(data));
+    if(!decompress(data, ret))
+        throw std::runtime_error("Yaz0: corrupt data");
+
+    return ret;
+}
+
+bool Yaz0File::decompress(std::span<const uint8_t> data, std::span<uint8_t> out)
+{
+    if(!isCompressed(data) || out.size() < decompressedSize(data))
+        return false;
+
+    uint32_t fullSize = decompressedSize(data);
+
+    Yaz0Decoder decoder(data, out.first(fullSize));
+    return decoder.decodeUpTo(fullSize);
+}
+
+std::vector<uint8_t> Yaz0File::compress(std::span<const uint8_t> data, Level level)
+{
+    uint32_t fullSize = data.size();
+
+    // worst case is all literals: one flag byte per 8 input bytes
+    std::vector<uint8_t> ret(16);
+    ret.reserve(16 + fullSize + (fullSize + 7) / 8);
+
+    ret[0] = 'Y'; ret[1] = 'a'; ret[2] = 'z'; ret[3] = '0';
+
+    ret[4] = (fullSize >> 24) & 0xFF;
+    ret[5] = (fullSize >> 16) & 0xFF;
+    ret[6] = (fullSize >> 8 ) & 0xFF;
+    ret[7] = (fullSize      ) & 0xFF;
+
+    TokenWriter writer(ret);
+
+    switch(level)
+    {
+        case Level::Store:
+            compressStore(data, ret);
+            break;
+        case Level::Fast:
+        case Level::Optimal:
+            if(fullSize > PARALLEL_THRESHOLD)
+                compressSegments(data, level, writer);
+            else
+                compressRange(data, 0, level, writer);
+            break;
+    }
+
+    // the encoders don't pick the same matches as each other (or as older versions), all that has to hold is
+    // that the decoder gives the input back. debug builds check that on every stream, segmented ones included
+    assert(std::ranges::equal(decompress(ret), data)); // Yaz0: compressed data doesn't round-trip
+
     return ret;
 }
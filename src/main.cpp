@@ -1,4 +1,5 @@
 #include "ui/Blackhole.h"
+#include "io/Yaz0Cache.h"
 #include <QApplication>
 
 #include <fstream>
@@ -21,6 +22,11 @@ int main(int argc, char *argv[])
 #endif
 
     QApplication app(argc, argv);
+
+    // --yaz0-cache keeps decompressed archives between runs, so opening them again is just a file mapping
+    if(app.arguments().contains("--yaz0-cache"))
+        Yaz0Cache::setDirectory(Yaz0Cache::defaultDirectory());
+
     Blackhole w;
     w.show();
 
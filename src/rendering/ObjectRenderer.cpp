@@ -1,6 +1,8 @@
 #include "rendering/ObjectRenderer.h"
 
 #include "Util.h"
+#include "io/ArchiveCache.h"
+#include "io/RarcFile.h"
 #include "rendering/Texture.h"
 
 #include <iostream>
@@ -22,16 +24,21 @@ ObjectRenderer::ObjectRenderer(BaseObject* obj)
     if(!fileInfo.exists())
         return; // TODO fallback to cube
 
-    m_rarc = RarcFile(filePath);
-    if(m_rarc.fileExists('/' + m_modelName + '/' + m_modelName + ".bdl"))
-        m_model = BmdFile(m_rarc.openFile('/' + m_modelName + '/' + m_modelName + ".bdl"));
-    else if(m_rarc.fileExists('/' + m_modelName + '/' + m_modelName + ".bmd"))
-        m_model = BmdFile(m_rarc.openFile('/' + m_modelName + '/' + m_modelName + ".bmd"));
+    std::shared_ptr<RarcFile> rarc = ArchiveCache::archive(filePath);
+    QString modelPath = '/' + m_modelName + '/' + m_modelName;
+
+    if(rarc->fileExists(modelPath + ".bdl"))
+        m_model = ArchiveCache::model(filePath, modelPath + ".bdl");
+    else if(rarc->fileExists(modelPath + ".bmd"))
+        m_model = ArchiveCache::model(filePath, modelPath + ".bmd");
+
+    if(m_model == nullptr)
+        return; // TODO fallback to cube
 
     std::vector<std::future<void>> futures;
     std::mutex m;
 
-    for(auto& tex : m_model.m_textures)
+    for(auto& tex : m_model->m_textures)
     {
         futures.push_back(std::async(std::launch::async, [&] {
             Texture decTex = Texture::fromBTI(tex);
@@ -47,6 +54,10 @@ void ObjectRenderer::initGL()
     auto gl = GalaxyRenderer::gl;
 
     VAO = 0;
+    nTris = 0;
+
+    if(m_model == nullptr)
+        return;
 
     unsigned int VBO = 0, EBO = 0;
     gl->glGenVertexArrays(1, &VAO);
@@ -55,15 +66,15 @@ void ObjectRenderer::initGL()
 
     gl->glBindVertexArray(VAO);
 
-    std::cout << m_model.m_positions.size() << " is the number of verts." << std::endl;;
+    std::cout << m_model->m_positions.size() << " is the number of verts." << std::endl;;
 
     gl->glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    gl->glBufferData(GL_ARRAY_BUFFER, 3 * sizeof(float) * m_model.m_positions.size(), m_model.m_positions.data(), GL_STATIC_DRAW);
+    gl->glBufferData(GL_ARRAY_BUFFER, 3 * sizeof(float) * m_model->m_positions.size(), m_model->m_positions.data(), GL_STATIC_DRAW);
 
     std::vector<float> indices;
 
     uint32_t i = 0;
-    for(auto& batch : m_model.m_batches)
+    for(auto& batch : m_model->m_batches)
     {
         for(auto& pkt : batch.packets)
         {
@@ -98,6 +109,9 @@ void ObjectRenderer::initGL()
 
 void ObjectRenderer::draw()
 {
+    if(m_model == nullptr)
+        return;
+
     GalaxyRenderer::gl->glBindVertexArray(VAO);
     GalaxyRenderer::gl->glDrawElements(GL_TRIANGLES, nTris, GL_UNSIGNED_INT, 0);
 
@@ -1,46 +1,59 @@
 #include "smg/BaseObject.h"
 
+#include "io/BcsvSchema.h"
+#include "ui/Blackhole.h"
+
 BaseObject::BaseObject(Zone& zone, const QString& dir, const QString& layer, const QString& fileName, BcsvFile::Entry& entry)
         : m_zone(zone), m_dir(dir), m_layer(layer), m_fileName(fileName), m_data(entry)
 {
-    m_name = m_data.getstr("name");
-
-    m_pos = glm::vec3(
-        m_data.getf("pos_x"),
-        m_data.getf("pos_y"),
-        m_data.getf("pos_z")
-    );
+    m_name = m_data.getstr("name"_bcsv);
 
-    m_rot = glm::vec3(
-        m_data.getf("dir_x"),
-        m_data.getf("dir_y"),
-        m_data.getf("dir_z")
-    );
-
-    m_scl = glm::vec3(1);
+    // tables without scale leave it at 1
+    BcsvSchema::Placement placement = m_data.read<BcsvSchema::Placement>();
+    m_pos = glm::vec3(placement.pos_x, placement.pos_y, placement.pos_z);
+    m_rot = glm::vec3(placement.dir_x, placement.dir_y, placement.dir_z);
+    m_scl = glm::vec3(placement.scale_x, placement.scale_y, placement.scale_z);
 }
 
-// todo *new jank?
 BaseObject::BaseObject(Zone& zone, const QString& dir, const QString& layer, const QString& fileName, const glm::vec3& pos)
-        : m_zone(zone), m_dir(dir), m_layer(layer), m_fileName(fileName), m_data(*new BcsvFile::Entry())
+        : m_zone(zone), m_dir(dir), m_layer(layer), m_fileName(fileName)
 {
     m_pos = pos;
     m_rot = glm::vec3(0);
     m_scl = glm::vec3(1);
 
-    m_data.insert("name", m_name);
-    m_data.insert("l_id", uint32_t(0));
+    // a known table's rows start out with all its fields at their defaults
+    const BcsvSchema* schema = BcsvSchema::find(fileName);
+    if(schema != nullptr)
+        m_data = schema->newRow(g_gameType);
+    else
+    {
+        m_data.insert("name"_bcsv, m_name);
+        m_data.insert("l_id"_bcsv, uint32_t(0));
+
+        m_data.insert("pos_x"_bcsv, 0.0f);
+        m_data.insert("pos_y"_bcsv, 0.0f);
+        m_data.insert("pos_z"_bcsv, 0.0f);
+
+        m_data.insert("dir_x"_bcsv, 0.0f);
+        m_data.insert("dir_y"_bcsv, 0.0f);
+        m_data.insert("dir_z"_bcsv, 0.0f);
+    }
+
+    savePlacement();
+}
 
-    m_data.insert("pos_x", m_pos.x);
-    m_data.insert("pos_y", m_pos.y);
-    m_data.insert("pos_z", m_pos.z);
+void BaseObject::savePlacement()
+{
+    m_data.insert("name"_bcsv, m_name);
 
-    m_data.insert("dir_x", m_rot.x);
-    m_data.insert("dir_y", m_rot.y);
-    m_data.insert("dir_z", m_rot.z);
+    m_data.write(BcsvSchema::Placement{
+        m_pos.x, m_pos.y, m_pos.z,
+        m_rot.x, m_rot.y, m_rot.z,
+        m_scl.x, m_scl.y, m_scl.z
+    });
 }
 
-
 int BaseObject::save()
 {
     return 0;
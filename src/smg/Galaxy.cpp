@@ -6,14 +6,15 @@
 Galaxy::Galaxy(const QString& galaxyName) : m_name(galaxyName)
 {
     RarcFile scenario(Util::absolutePath("StageData/" + m_name + '/' + m_name + "Scenario.arc"));
-    BcsvFile zonesBcsv(scenario.openFile('/' + m_name + "Scenario/ZoneList.bcsv"));
+    // only a field or two of these get read, so they're decoded as they are
+    BcsvFile zonesBcsv(scenario.openFile('/' + m_name + "Scenario/ZoneList.bcsv"), true);
 
     for(const BcsvFile::Entry& entry : zonesBcsv.m_entries)
-        m_zoneList.push_back(std::get<QString>(entry["ZoneName"]));
+        m_zoneList.push_back(std::get<QString>(entry["ZoneName"_bcsv]));
 
     zonesBcsv.close();
 
-    BcsvFile scenarioBcsv(scenario.openFile('/' + m_name + "Scenario/ScenarioData.bcsv"));
+    BcsvFile scenarioBcsv(scenario.openFile('/' + m_name + "Scenario/ScenarioData.bcsv"), true);
     m_scenarioData = scenarioBcsv.m_entries;
 
     scenarioBcsv.close();
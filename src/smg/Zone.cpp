@@ -50,9 +50,7 @@ Zone::Zone(Galaxy* parent, const QString& name) : m_galaxy(parent), m_zoneName(n
 
 void Zone::loadObjects(const QString& dir, const QString& file)
 {
-    QStringList layers = m_map.getSubDirectories("/Stage/Jmp/" + dir);
-
-    for(const QString& layer : layers)
+    for(const QString& layer : m_map.subDirectories("/Stage/Jmp/" + dir))
     {
         QString filePath = dir + '/' + layer + '/' + file;
 
@@ -14,21 +14,12 @@ ZoneObject::ZoneObject(Zone& zone, const QString& dir, const QString& layer, con
 ZoneObject::ZoneObject(Zone& zone, const QString& dir, const QString& layer, const QString& fileName, const glm::vec3& pos)
         : BaseObject(zone, dir, layer, fileName, pos)
 {
-
 }
 
 int ZoneObject::save()
 {
-    m_data.insert("name", m_name);
-
-    m_data.insert("pos_x", m_pos.x);
-    m_data.insert("pos_y", m_pos.y);
-    m_data.insert("pos_z", m_pos.z);
-
     // TODO shouldn't we also flip Z and X here?
-    m_data.insert("dir_x", m_rot.x);
-    m_data.insert("dir_y", m_rot.y);
-    m_data.insert("dir_z", m_rot.z);
+    savePlacement();
 
     return 0;
 }